@@ -18,7 +18,8 @@ def setup_parser(common_parser, subparsers):
         required=True,
     )
 
-    parser.add_argument(
+    reads_or_checkpoint = parser.add_mutually_exclusive_group(required=True)
+    reads_or_checkpoint.add_argument(
         "--reads",
         help="One or more read files.\n"
         "Valid formats: fastq, sam/bam/cram, fasta, txt; compressed or uncompressed; fuzzy extensions (eg fq, fsq for fastq).\n"
@@ -27,7 +28,33 @@ def setup_parser(common_parser, subparsers):
         nargs="+",
         action="append",
         type=str,
-        required=True,
+    )
+    reads_or_checkpoint.add_argument(
+        "--from_checkpoint",
+        help="Coverage checkpoint from a previous run on the same prg "
+        "(coverage/coverage_checkpoint.bin), or made by merging several with "
+        "`merge_coverage`: genotype from it instead of mapping reads.",
+        type=str,
+    )
+
+    parser.add_argument(
+        "--stop_after_mapping",
+        help="Only map reads and write coverage, including the coverage "
+        "checkpoint to genotype from later with --from_checkpoint.",
+        action="store_true",
+    )
+
+    parser.add_argument(
+        "--gzip_coverage",
+        help="gzip the coverage files (not the coverage checkpoint).",
+        action="store_true",
+    )
+
+    parser.add_argument(
+        "--bgzip_personalised_ref",
+        help="bgzip the personalised reference, and index it with a .gzi file "
+        "as well as a .fai file.",
+        action="store_true",
     )
 
     parser.add_argument(
@@ -52,6 +79,47 @@ def setup_parser(common_parser, subparsers):
         required=False,
     )
 
+    parser.add_argument(
+        "--max_read_occurrences",
+        help="Reads mapping to more places in the prg than this are treated as "
+        "repetitive (see --repetitive_reads).\n"
+        "Default: 0 (no maximum).",
+        type=int,
+        default=0,
+        required=False,
+    )
+
+    parser.add_argument(
+        "--repetitive_reads",
+        help="What to do with repetitive reads: skip them, or use an evenly "
+        "spread subset of their mapping instances.\n"
+        "Default: skip",
+        choices=["skip", "downsample"],
+        required=False,
+        default="skip",
+    )
+
+    parser.add_argument(
+        "--gcp_cache_dir",
+        help="Directory in which to cache the simulated genotype confidences "
+        "used for confidence percentiles, to reuse across samples with the same "
+        "ploidy and similar coverage depth and error rate: these get rounded to "
+        "a grid with 5% steps, and confidences are simulated from the rounded "
+        "values.\n"
+        "Default: None (no caching).",
+        type=str,
+        required=False,
+    )
+
+    parser.add_argument(
+        "--genotype_store",
+        help="Genotype store (directory) to append the genotyped sample to, "
+        "for combining many samples. It is created if it does not exist.\n"
+        "Default: None (no store).",
+        type=str,
+        required=False,
+    )
+
     parser.add_argument(
         "--seed",
         help="Fix the seed to produce the same read mappings across different runs."
@@ -22,6 +22,9 @@ log = logging.getLogger("gramtools")
 
 
 def run(args):
+    if args.from_checkpoint is not None and args.stop_after_mapping:
+        log.error("--stop_after_mapping cannot be used with --from_checkpoint")
+        exit(1)
     geno_paths = GenotypePaths(args.geno_dir, args.force)
     geno_paths.setup(args)
 
@@ -38,7 +41,8 @@ def run(args):
 
     _check_read_stats(geno_report, "check_read_stats", geno_paths)
 
-    _make_rebasing_map(geno_paths)
+    if not args.stop_after_mapping:
+        _make_rebasing_map(geno_paths)
 
     log.debug("Computing sha256 hash of project paths")
     command_hash_paths = common.hash_command_paths(geno_paths)
@@ -73,8 +77,6 @@ def _execute_command_cpp_genotype(geno_report, action, geno_paths, args):
         "genotype",
         "--gram_dir",
         str(geno_paths.gram_dir),
-        "--reads",
-        *list(map(str, geno_paths.reads_files)),
         "--sample_id",
         args.sample_id,
         "--ploidy",
@@ -85,10 +87,28 @@ def _execute_command_cpp_genotype(geno_report, action, geno_paths, args):
         str(geno_paths.geno_dir),
         "--max_threads",
         str(args.max_threads),
+        "--max_read_occurrences",
+        str(args.max_read_occurrences),
+        "--repetitive_reads",
+        args.repetitive_reads,
     ]
 
+    if args.from_checkpoint is not None:
+        command += ["--from_checkpoint", str(geno_paths.input_checkpoint)]
+    else:
+        command += ["--reads", *list(map(str, geno_paths.reads_files))]
+    if args.stop_after_mapping:
+        command += ["--stop_after_mapping"]
+    if args.gzip_coverage:
+        command += ["--gzip_coverage"]
+    if args.bgzip_personalised_ref:
+        command += ["--bgzip_personalised_ref"]
     if args.seed is not None:
         command += ["--seed", str(args.seed)]
+    if args.gcp_cache_dir is not None:
+        command += ["--gcp_cache_dir", args.gcp_cache_dir]
+    if args.genotype_store is not None:
+        command += ["--genotype_store", args.genotype_store]
     if args.debug:
         command += ["--debug"]
 
@@ -149,13 +149,27 @@ class GenotypePaths(ProjectPaths):
         # Infer-related
         self.geno_vcf = self.results_path("genotyped.vcf.gz")
         self.pers_ref = self.results_path("personalised_reference.fasta")
+        # A finished run (as read by discover) may have bgzipped it
+        bgzipped_pers_ref = self.results_path("personalised_reference.fasta.gz")
+        if not self.pers_ref.exists() and bgzipped_pers_ref.exists():
+            self.pers_ref = bgzipped_pers_ref
         self.rebasing_map = self.results_path("rebasing_map.json")
 
     def setup(self, args):
         super().initial_setup()
         self.reads_dir.mkdir()
         self._link_to_build(args.gram_dir)
-        self._link_to_reads(args.reads)
+        if args.gzip_coverage:
+            self.gped_cov = self.cov_path("grouped_allele_counts_coverage.json.gz")
+            self.pb_cov = self.cov_path("allele_base_coverage.json.gz")
+        if args.bgzip_personalised_ref:
+            self.pers_ref = self.results_path("personalised_reference.fasta.gz")
+        if args.from_checkpoint is not None:
+            self.reads_files = []
+            self.input_checkpoint = Path(args.from_checkpoint).resolve()
+            self.check_exists(self.input_checkpoint)
+        else:
+            self._link_to_reads(args.reads)
 
     def _link_to_build(self, existing_gram_dir):
         """
@@ -53,6 +53,20 @@ def setup_parser(common_parser, subparsers):
         required=False,
         default="",
     )
+    parser.add_argument(
+        "--max_threads",
+        help="Max number of threads to use. Default: 1.",
+        type=int,
+        default=1,
+        required=False,
+    )
+    parser.add_argument(
+        "--seed",
+        help="Fix the seed to produce the same simulated paths across different runs."
+        " Default: None (seed gets randomly generated).",
+        type=int,
+        required=False,
+    )
 
 
 def run(args):
@@ -84,8 +98,12 @@ def _execute_command_cpp_simulate(simu_paths, args):
         args.sample_id,
         "--o",
         str(simu_paths.output_dir),
+        "--max_threads",
+        str(args.max_threads),
     ] + input_multifasta
 
+    if args.seed is not None:
+        command += ["--seed", str(args.seed)]
     if args.debug:
         command += ["--debug"]
 
@@ -10,8 +10,16 @@
 #include "prg/coverage_graph.hpp"
 
 namespace gram {
+/** Number of bytes of the (decompressed) reference read at a time */
+constexpr std::size_t REF_CHECK_BUFFER_SIZE{1 << 16};
+
 class PrgRefChecker {
  public:
+  /**
+   * Reads the reference one buffer at a time and compares it in place to the
+   * first path of the graph, walked alongside it: memory use does not grow
+   * with the size of either.
+   */
   PrgRefChecker(std::istream &fasta_ref_handle, coverage_Graph const &cov_graph,
                 bool const gzipped = false);
 
@@ -0,0 +1,24 @@
+#ifndef GRAMTOOLS_FILE_WRITE_HPP
+#define GRAMTOOLS_FILE_WRITE_HPP
+
+#include <fstream>
+
+#include <boost/iostreams/filtering_stream.hpp>
+
+/**
+ * A buffered output file, optionally gzip-compressed.
+ * Data is flushed, and the gzip stream finalised, on destruction.
+ */
+class OutputFile {
+ public:
+  static constexpr std::streamsize buffer_size = 1 << 16;
+
+  OutputFile(std::string const &fpath, bool gzipped);
+  std::ostream &stream() { return out; }
+
+ private:
+  std::ofstream file;
+  boost::iostreams::filtering_ostream out;  // Destroyed, so closed, first
+};
+
+#endif  // GRAMTOOLS_FILE_WRITE_HPP
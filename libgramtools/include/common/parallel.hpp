@@ -0,0 +1,30 @@
+#ifndef GRAMTOOLS_PARALLEL_HPP
+#define GRAMTOOLS_PARALLEL_HPP
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+
+namespace gram {
+
+/**
+ * Runs `f(0)`...`f(n-1)` in parallel. Exceptions cannot leave an OpenMP
+ * region, so they are rethrown once all calls have finished.
+ */
+template <typename Function>
+void parallel_for(std::size_t n, Function f) {
+  std::vector<std::exception_ptr> errors(n);
+#pragma omp parallel for
+  for (std::size_t i = 0; i < n; ++i) {
+    try {
+      f(i);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  }
+  for (auto const& error : errors)
+    if (error) std::rethrow_exception(error);
+}
+}  // namespace gram
+
+#endif  // GRAMTOOLS_PARALLEL_HPP
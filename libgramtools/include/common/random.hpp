@@ -2,6 +2,7 @@
 #define GRAMTOOLS_RANDOM_HPP
 
 #include <cstdint>
+#include <limits>
 #include <random>
 
 #include "genotype/parameters.hpp"
@@ -17,11 +18,9 @@ class RandomGenerator {
 
   virtual uint32_t generate(uint32_t min, uint32_t max) = 0;
 
-  SeedSize operator()() { return random_number_generator(); }
-
- protected:
-  std::mt19937
-      random_number_generator;  // 32-bit unsigned random number generator
+  virtual SeedSize operator()() {
+    return generate(0, std::numeric_limits<SeedSize>::max());
+  }
 };
 
 class RandomInclusiveInt : public RandomGenerator {
@@ -31,11 +30,38 @@ class RandomInclusiveInt : public RandomGenerator {
   RandomInclusiveInt(Seed const& random_seed);
 
   uint32_t generate(uint32_t min, uint32_t max) override;
+  SeedSize operator()() override { return random_number_generator(); }
   Seed const& get_seed() const { return seed; }
 
  private:
   Seed seed = std::nullopt;
+  std::mt19937
+      random_number_generator;  // 32-bit unsigned random number generator
 };
+
+/**
+ * Counter-based generator (SplitMix64): each draw hashes a counter started at
+ * `key`. Its state is a single integer, so unlike `RandomInclusiveInt` it is
+ * practically free to construct; it is used to make one generator per read.
+ */
+class CounterRandomInt : public RandomGenerator {
+ public:
+  explicit CounterRandomInt(uint64_t key) : state(key) {}
+
+  uint32_t generate(uint32_t min, uint32_t max) override;
+  SeedSize operator()() override { return next() >> 32; }
+
+ private:
+  uint64_t next();
+  uint64_t state;
+};
+
+/**
+ * Derives the seed of the `index`th item (eg read) processed in a run from
+ * the run's `master_seed`. Does not depend on the processing order, so results
+ * are the same whatever the buffering and the number of threads.
+ */
+SeedSize derive_seed(SeedSize const& master_seed, uint64_t const& index);
 }  // namespace gram
 
 #endif  // GRAMTOOLS_RANDOM_HPP
@@ -1,6 +1,8 @@
 #ifndef ALLELE_EXTRACTER_HPP
 #define ALLELE_EXTRACTER_HPP
 
+#include <deque>
+
 #include "prg/types.hpp"
 #include "types.hpp"
 
@@ -14,15 +16,57 @@ namespace gram::genotype::infer {
  */
 Allele extract_ref_allele(covG_ptr start_node, covG_ptr end_node);
 
+/**
+ * An allele under construction, held as the list of pieces making it up:
+ * coverage graph nodes and alleles of previously genotyped sites. Copying and
+ * extending a rope copies no sequence or coverage; `materialise` builds the
+ * contiguous `Allele` once all pieces are known.
+ * The referred-to nodes and alleles must outlive the rope.
+ */
+class AlleleRope {
+ private:
+  struct Segment {
+    coverage_Node const* node;
+    Allele const* allele;
+  };
+  std::vector<Segment> segments;
+  std::size_t length{0};
+
+ public:
+  AlleleId haplogroup;
+  bool callable = true;
+
+  explicit AlleleRope(AlleleId haplogroup = 0) : haplogroup(haplogroup) {}
+
+  /** Appends the sequence and coverage of a node */
+  void append(coverage_Node const& node);
+
+  /**
+   * Appends a previously genotyped allele. As for `Allele::operator+`, an
+   * uncallable allele makes the rope uncallable.
+   */
+  void append(Allele const& allele);
+
+  std::size_t size() const { return length; }
+
+  Allele materialise() const;
+};
+using rope_vector = std::vector<AlleleRope>;
+
+allele_vector materialise(rope_vector const& ropes);
+
 /**
  * Class in charge of producing the set of `Allele`s that get genotyped.
  * The procedure scans through each haplogroup of a site, pasting sequence &
  * coverage from previously genotyped (=nested) sites when encountered.
+ * Alleles are built as `AlleleRope`s and only materialised once per haplogroup
+ * traversal, so that nested sites do not repeatedly copy long sequences.
  */
 class AlleleExtracter {
  private:
   allele_vector alleles;
   gt_sites const* genotyped_sites;
+  std::deque<Allele> nested_alleles;  // Pieces of ropes from nested sites
 
  public:
   AlleleExtracter() : genotyped_sites(nullptr){};
@@ -49,8 +93,8 @@ class AlleleExtracter {
    * @param site_index the previously genotyped site
    * @return Cartesian product of `existing` and distinct genotyped alleles
    */
-  allele_vector allele_combine(allele_vector const& existing,
-                               std::size_t site_index);
+  rope_vector allele_combine(rope_vector const& existing,
+                             std::size_t site_index);
 
   /**
    * From a set of existing alleles, paste sequence and pb coverage to the end
@@ -59,7 +103,7 @@ class AlleleExtracter {
    * @param sequence_node  the haplogroup common node
    * @return void because `existing` is modified in place
    */
-  void allele_paste(allele_vector& existing, covG_ptr sequence_node);
+  void allele_paste(rope_vector& existing, covG_ptr sequence_node);
 };
 }  // namespace gram::genotype::infer
 
@@ -29,6 +29,9 @@ struct ModelData {
   Ploidy ploidy;
   likelihood_related_stats const *l_stats;
   bool debug = false;
+  /** Above this many candidate alleles, the heterozygous genotype search is
+   * bounded */
+  std::size_t max_exhaustive_het_alleles = 16;
 
   ModelData() : gp_counts() {}
 
@@ -107,6 +110,9 @@ class LevelGenotyperModel : GenotypingModel {
                       double const &incompatible_coverage,
                       GtypedIndices const &allele_indices);
 
+  double compute_likelihood(allele_vector const &alleles,
+                            double const &incompatible_coverage);
+
   /**
    * Haploid genotype likelihood
    */
@@ -128,6 +134,19 @@ class LevelGenotyperModel : GenotypingModel {
       allele_vector const &input_alleles,
       multiplicities const &haplogroup_multiplicities);
 
+  /**
+   * Diploid heterozygous, for sites with many candidate alleles.
+   * Only adds the likelihoods `CallGenotype` can use: of the two best callable
+   * genotypes, and of uncallable ones scoring at least as high as the second
+   * best callable genotype. Pairs are visited in decreasing order of an upper
+   * bound of their likelihood, which assumes that none of the coverage on
+   * the pair's haplogroups is incompatible with the pair; the search stops
+   * once the bound is below the second best callable likelihood.
+   */
+  void compute_bounded_heterozygous_log_likelihoods(
+      allele_vector const &input_alleles, GtypedIndices const &candidates,
+      multiplicities const &haplogroup_multiplicities);
+
   /** For producing the diploid combinations. */
   std::vector<GtypedIndices> get_permutations(GtypedIndices const &indices,
                                               std::size_t subset_size);
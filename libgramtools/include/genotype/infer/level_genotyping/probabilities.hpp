@@ -3,6 +3,8 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 
 #include "genotype/quasimap/coverage/types.hpp"
@@ -11,15 +13,29 @@ namespace gram::genotype::infer::probabilities {
 using params = std::vector<double>;
 using memoised_params = std::map<params, double>;
 
+/**
+ * Memoises computed probabilities. Can be queried from several threads at
+ * once: memoisation is guarded by a lock.
+ */
 class AbstractPmf {
  protected:
   AbstractPmf() = default;
+  AbstractPmf(AbstractPmf const& other) : probs(other.probs) {}
+  AbstractPmf& operator=(AbstractPmf const& other) {
+    probs = other.probs;
+    return *this;
+  }
   memoised_params probs;  // Memoised probabilities
   virtual double compute_prob(params const& query) const = 0;
 
+ private:
+  std::shared_mutex probs_mutex;
+
  public:
   virtual ~AbstractPmf() = default;
   double operator()(params const& query);
+  /** Computes a probability without memoising it. */
+  double evaluate(params const& query) const { return compute_prob(query); }
   memoised_params const& get_probs() const { return probs; }
 };
 
@@ -42,6 +58,26 @@ class NegBinomLogPmf : public AbstractPmf {
 };
 
 using pmf_ptr = std::shared_ptr<AbstractPmf>;
+
+/**
+ * Tabulates a log pmf of coverage, on a grid of coverages
+ * 0, 1/`resolution`, 2/`resolution`... up to `max_cov`.
+ * Coverages on the grid, which include all integer coverages, are looked up
+ * exactly; other coverages are linearly interpolated between the two closest
+ * grid points. Coverages beyond the grid are given by the pmf itself.
+ */
+class LogPmfTable {
+  pmf_ptr pmf;
+  std::size_t resolution{1};
+  std::vector<double> values;
+
+ public:
+  LogPmfTable() = default;
+  LogPmfTable(pmf_ptr pmf, double max_cov, std::size_t resolution = 64);
+  double operator()(double cov) const;
+  std::size_t size() const { return values.size(); }
+};
+
 struct DataParams {
   double mean_cov{-1};
   double mean_pb_error{-1};
@@ -65,6 +101,8 @@ struct likelihood_related_stats {
                               coverage (per-base)*/
   pmf_ptr pmf_full_depth;
   pmf_ptr pmf_half_depth;
+  LogPmfTable log_pmf_full_depth; /**< Lookups of `pmf_full_depth`, used for
+                                     computing likelihoods */
 };
 
 std::ostream& operator<<(std::ostream& os,
@@ -25,6 +25,13 @@ class ReadStats;
 }  // namespace gram
 
 namespace gram::genotype::infer {
+/** Seeds the draws of genotype confidences used for percentiles */
+constexpr SeedSize gcp_seed{42};
+/**
+ * Relative spacing of the grid to which coverage model parameters are rounded
+ * when caching simulated genotype confidences
+ */
+constexpr double gcp_cache_grid_step{0.05};
 
 using lvlgt_site_ptr = std::shared_ptr<LevelGenotypedSite>;
 
@@ -32,15 +39,29 @@ class LevelGenotyper : public Genotyper {
   likelihood_related_stats l_stats;
   Ploidy ploidy;
 
+  /**
+   * Genotypes one site, then invalidates and filters the sites nested in it.
+   * Only reads and writes records of the site and of sites nested in it, which
+   * must all have been genotyped already.
+   * @return the site's debug entry, if `debug` is set.
+   */
+  std::string genotype_site(covG_ptr const& site_start,
+                            covG_ptr const& site_end, bool debug);
+
  public:
   LevelGenotyper() = default;
   LevelGenotyper(child_map const& ch, gt_sites const& sites)
       : Genotyper(sites, ch) {}
 
+  /**
+   * Genotypes all sites of `cov_graph`. A site gets genotyped after all sites
+   * nested in it; sites not nested in each other are genotyped in parallel.
+   */
   LevelGenotyper(coverage_Graph const& cov_graph,
                  SitesGroupedAlleleCounts const& gped_covs,
                  ReadStats const& read_stats, Ploidy ploidy,
-                 bool get_gcp = false, std::string debug_fpath = "");
+                 bool get_gcp = false, std::string debug_fpath = "",
+                 std::string gcp_cache_dirpath = "");
 
   header_vec get_model_specific_headers() override;
 
@@ -63,9 +84,25 @@ class LevelGenotyper : public Genotyper {
   static likelihood_related_stats make_l_stats(double mean_cov, double var_cov,
                                                double mean_pb_error);
   static CovCount find_minimum_non_error_cov(double mean_pb_error, pmf_ptr pmf);
+
+  /**
+   * Simulates genotype confidences of sites under the coverage model of
+   * `input_lstats`, in parallel. Blocks of simulations are seeded from `seed`
+   * and their index, so results do not depend on the number of threads, and
+   * simulating n confidences gives the first n of simulating more.
+   */
+  static std::vector<double> simulate_gtconfs(
+      likelihood_related_stats const& input_lstats, Ploidy const& input_ploidy,
+      std::size_t num_simulations, SeedSize seed = gcp_seed);
+
+  /**
+   * @param cache_dirpath if not empty, simulated confidences are reused from
+   * and stored in this directory, keyed by ploidy and by coverage model
+   * rounded to a grid: they are then simulated under the rounded model.
+   */
   std::vector<double> static get_gtconf_distrib(
       gt_sites const& input_sites, likelihood_related_stats const& input_lstats,
-      Ploidy const& input_ploidy);
+      Ploidy const& input_ploidy, std::string const& cache_dirpath = "");
 };
 }  // namespace gram::genotype::infer
 
@@ -0,0 +1,174 @@
+/** @file
+ * Columnar, chunked binary store of the genotypes of many samples on one PRG.
+ *
+ * A store is a directory holding:
+ *  - `lock`: locked by appends, so that several processes can append at once
+ *  - `meta.bin`: the top-level JSON entries (Model, Samples, Child_Map...) and
+ *  the number of samples and site fields of each appended batch
+ *  - `sites.bin`: POS, SEG and REF allele of each site
+ *  - `batch_<b>/chunk_<c>.bin`: the genotypes of the samples of batch `b` on
+ *  the sites of chunk `c`, one column per field
+ *
+ * Samples get appended one batch (= one genotyped JSON) at a time, without
+ * rewriting existing batches. Site ranges are read back by loading only the
+ * chunks covering them, and combining batches as `combine_jvcfs` does.
+ */
+#ifndef GENOTYPE_STORE_HPP
+#define GENOTYPE_STORE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "genotype/infer/types.hpp"
+#include "json_combine.hpp"
+
+namespace gram::json {
+
+constexpr uint32_t GENOTYPE_STORE_VERSION{1};
+constexpr std::size_t GENOTYPE_STORE_SITES_PER_CHUNK{16384};
+
+class GenotypeStoreException : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+/**
+ * Variable-length entries stored back to back: entry i is
+ * `values[offsets[i]..offsets[i + 1])`.
+ */
+template <typename T>
+struct ragged_column {
+  std::vector<T> values;
+  std::vector<uint64_t> offsets{0};
+
+  template <typename Container>
+  void push_back(Container const& entry) {
+    values.insert(values.end(), entry.begin(), entry.end());
+    offsets.push_back(values.size());
+  }
+  std::vector<T> at(std::size_t i) const {
+    return std::vector<T>(values.begin() + offsets.at(i),
+                          values.begin() + offsets.at(i + 1));
+  }
+  std::size_t size() const { return offsets.size() - 1; }
+
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int /*version*/) {
+    ar& values;
+    ar& offsets;
+  }
+};
+
+/**
+ * A site field specific to the genotyping model (eg GT_CONF), holding one
+ * number or one array of numbers per sample. Null numbers are stored as NaN.
+ */
+struct model_field_column {
+  ragged_column<double> values;
+  std::vector<bool> is_array;
+
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int /*version*/) {
+    ar& values;
+    ar& is_array;
+  }
+};
+
+/**
+ * The genotypes of one batch of samples on one chunk of sites.
+ * `alt_alleles` has one entry per site; all other columns one entry per site
+ * and sample, site-major.
+ */
+struct GenotypeStoreChunk {
+  ragged_column<std::string> alt_alleles;
+  ragged_column<genotype::infer::GtypedIndex> genotypes;  // {-1}: null call
+  ragged_column<AlleleId> haplogroups;
+  ragged_column<double> coverages;
+  std::vector<uint64_t> depths;
+  ragged_column<std::string> filters;
+  std::vector<model_field_column> model_fields;
+
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int /*version*/) {
+    ar& alt_alleles;
+    ar& genotypes;
+    ar& haplogroups;
+    ar& coverages;
+    ar& depths;
+    ar& filters;
+    ar& model_fields;
+  }
+};
+
+class GenotypeStore {
+ private:
+  std::string dirpath;
+  std::size_t sites_per_chunk;
+  JSON header;  // Top-level JSON entries, with an empty "Sites"
+  std::vector<std::size_t> batch_sizes;
+  /** Names of the model-specific site fields of each batch */
+  std::vector<strings> batch_model_fields;
+
+  std::vector<uint64_t> positions;
+  strings segment_IDs;
+  std::vector<uint32_t> segments;  // Index in `segment_IDs` of each site
+  strings refs;
+
+  std::string batch_dirpath(std::size_t batch) const;
+  std::string chunk_fpath(std::size_t batch, std::size_t chunk) const;
+  void read_meta();
+  void write_meta() const;
+  void write_sites() const;
+  GenotypeStoreChunk read_chunk(std::size_t batch, std::size_t chunk) const;
+  void write_chunk(GenotypeStoreChunk const& chunk, std::size_t batch,
+                   std::size_t chunk_index) const;
+
+  /** Checks the site matches the stored one, or stores it if new */
+  void add_site_position(JSON const& site, std::size_t site_index,
+                         bool new_sites);
+  /** Site `site_index` of a batch, as it was in the appended JSON */
+  JSON make_site(GenotypeStoreChunk const& chunk, std::size_t chunk_site,
+                 std::size_t site_index, std::size_t batch) const;
+
+ public:
+  /**
+   * Opens the store in `dirpath`, or prepares an empty one there if it does
+   * not exist yet. `sites_per_chunk` only applies to new stores.
+   */
+  explicit GenotypeStore(
+      std::string dirpath,
+      std::size_t sites_per_chunk = GENOTYPE_STORE_SITES_PER_CHUNK);
+
+  /**
+   * Appends all samples of a genotyped JSON, read one site at a time.
+   * The JSON must be combinable with those already stored; `force` allows
+   * duplicate sample names, as in `combine_jvcfs`.
+   * Appends from concurrent processes are serialised with an exclusive lock
+   * on the store's `lock` file (advisory: this needs a filesystem supporting
+   * `flock`).
+   */
+  void append(JsonSiteReader& reader, bool force = false);
+
+  std::size_t num_sites() const { return positions.size(); }
+  std::size_t num_batches() const { return batch_sizes.size(); }
+  JSON const& get_header() const { return header; }
+
+  /**
+   * Sites `first` (included) to `last` (excluded), each combined across all
+   * samples. Only the chunks covering the range get read, in parallel.
+   */
+  std::vector<JSON> get_sites(std::size_t first, std::size_t last) const;
+
+  /**
+   * Writes the same JSON as combining the appended JSONs with
+   * `combine_json_prgs`, one chunk of sites at a time.
+   */
+  void write_json(std::ostream& out) const;
+
+  /** Writes the sites not nested in any other to a multi-sample vcf */
+  void write_vcf(std::string const& fpath, std::size_t num_threads = 1) const;
+};
+}  // namespace gram::json
+
+#endif  // GENOTYPE_STORE_HPP
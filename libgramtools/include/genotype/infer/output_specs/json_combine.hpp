@@ -0,0 +1,61 @@
+/** @file
+ * K-way merging of genotyped JSONs, reading and writing one chunk of sites at
+ * a time rather than holding whole documents in memory.
+ */
+#ifndef JSON_COMBINE_HPP
+#define JSON_COMBINE_HPP
+
+#include <istream>
+#include <ostream>
+
+#include "json_prg_spec.hpp"
+#include "json_site_spec.hpp"
+
+namespace gram::json {
+
+/**
+ * Reads a genotyped JSON one site at a time.
+ * All entries other than "Sites" get read on construction; "Sites" needs to be
+ * the last entry, which it is in all JSONs dumped by gramtools (entries get
+ * written in sorted order).
+ */
+class JsonSiteReader {
+ private:
+  std::istream* in;
+  std::string name;
+  JSON header;
+  bool sites_left{false};
+
+  char next_char();
+  void expect(char expected);
+
+ public:
+  JsonSiteReader(std::istream& in, std::string name);
+
+  /** The JSON document, with an empty "Sites" array */
+  JSON const& get_header() const { return header; }
+
+  /** Reads the next site into `site`; returns false once all are read */
+  bool next_site(JSON& site);
+};
+
+/**
+ * Combines the same site across several JSONs in one go.
+ * Gives the same site as combining them pairwise, in order, using
+ * `Json_Site::combine_with`: the REF allele comes first, then alleles called
+ * in any sample in their order of appearance.
+ */
+JSON combine_sites(std::vector<JSON> sites, std::string const& gtyping_model);
+
+/**
+ * Combines the JSONs read from `inputs` and writes the result to `out`.
+ * Sites are read and combined in chunks of `sites_per_chunk`, each chunk in
+ * parallel, so memory use does not grow with the number of sites.
+ */
+void combine_json_prgs(std::vector<std::istream*> const& inputs,
+                       std::vector<std::string> const& input_names,
+                       std::ostream& out, std::size_t sites_per_chunk,
+                       bool force = false);
+}  // namespace gram::json
+
+#endif  // JSON_COMBINE_HPP
@@ -1,6 +1,8 @@
 #ifndef PRG_JSON_SPEC
 #define PRG_JSON_SPEC
 
+#include <functional>
+#include <ostream>
 #include <utility>
 
 #include "fields.hpp"
@@ -16,6 +18,13 @@ class Json_Prg {
   Json_Prg() : json_prg(gram::json::spec::json_prg) {}
   explicit Json_Prg(JSON input_json);
   void add_samples(Json_Prg& other, bool force = false);
+  /**
+   * Appends `samples` to this JSON's Samples, renaming duplicate names if
+   * `force` is set.
+   */
+  void add_sample_names(JSON samples, bool force = false);
+  /** Throws if `other_prg` does not have the same model, PRG and fields */
+  void check_combinable(JSON const& other_prg) const;
   void combine_with(Json_Prg& other, bool force = false);
   void set_sample_info(std::string const& name, std::string const& desc);
 
@@ -24,6 +33,15 @@ class Json_Prg {
   JSON& get_prg() { return json_prg; }
   void set_prg(JSON const& input_json);
 };
+
+/**
+ * Writes `header` to `out` in the same layout as `JSON::dump()`, except that
+ * the value of its "Sites" entry is written by `write_sites`. This lets the
+ * sites be streamed rather than held in memory.
+ */
+void write_json_with_streamed_sites(
+    std::ostream& out, JSON const& header,
+    std::function<void(std::ostream&)> const& write_sites);
 }  // namespace gram::json
 
 #endif  // PRG_JSON_SPEC
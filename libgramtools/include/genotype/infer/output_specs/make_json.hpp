@@ -1,6 +1,8 @@
 #ifndef GTYPE_MAKE_JSON_HPP
 #define GTYPE_MAKE_JSON_HPP
 
+#include <ostream>
+
 #include "genotype/infer/interfaces.hpp"
 #include "json_prg_spec.hpp"
 #include "json_site_spec.hpp"
@@ -14,8 +16,20 @@ namespace gram::genotype {
 class SegmentTracker;
 }
 
+/** Number of json sites serialised in parallel before getting written */
+constexpr std::size_t JSON_SITES_PER_CHUNK{4096};
+
 json_prg_ptr make_json_prg(gtyper_ptr const& gtyper, SegmentTracker& tracker);
 
+/**
+ * Writes the same document as `make_json_prg` followed by `set_sample_info`,
+ * without holding it all in memory: the sites get serialised in parallel, one
+ * chunk at a time, and streamed to `out` in order.
+ */
+void write_json_prg(std::ostream& out, gtyper_ptr const& gtyper,
+                    SegmentTracker& tracker, std::string const& sample_name,
+                    std::string const& sample_desc);
+
 /**
  * Populates the PRG-related entries (Lvl1_sites, child map) of a Json_Prg
  * class.
@@ -24,4 +38,9 @@ void populate_json_prg(Json_Prg& json_prg, gtyper_ptr const& gtyper);
 
 json_site_ptr make_json_site(gt_site_ptr const& gt_site);
 
+/** Makes a json site with its segment ID and 1-based position set */
+json_site_ptr make_positioned_json_site(gt_site_ptr const& gt_site,
+                                        std::string const& segment_ID,
+                                        std::size_t relative_pos);
+
 #endif  // GTYPE_MAKE_JSON_HPP
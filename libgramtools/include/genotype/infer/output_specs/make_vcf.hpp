@@ -14,6 +14,9 @@ namespace gram::genotype {
 class SegmentTracker;
 }
 
+/** Number of vcf records populated in parallel before getting written */
+constexpr std::size_t VCF_RECORDS_PER_CHUNK{4096};
+
 class VcfWriteException : public std::exception {
  protected:
   std::string msg;
@@ -34,4 +37,11 @@ void write_sites(htsFile *fout, bcf_hdr_t *header, gtyper_ptr const &gtyper,
 void populate_vcf_site(bcf_hdr_t *header, bcf1_t *record, gt_site_ptr site,
                        SegmentTracker &tracker);
 
+/** Sets CHROM and POS. Sites must be passed in increasing position order */
+void set_vcf_position(bcf_hdr_t *header, bcf1_t *record,
+                      gt_site_ptr const &site, SegmentTracker &tracker);
+/** Sets all other fields; safe to call concurrently on distinct records */
+void populate_vcf_entries(bcf_hdr_t *header, bcf1_t *record,
+                          gt_site_ptr const &site);
+
 #endif  // MAKE_VCF_HPP
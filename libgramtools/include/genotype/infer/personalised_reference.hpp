@@ -1,6 +1,8 @@
 #ifndef GRAM_PERSONALISED_REF_H
 #define GRAM_PERSONALISED_REF_H
 
+#include <set>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include "genotype/infer/types.hpp"
@@ -12,15 +14,28 @@ namespace gram::genotype {
 class SegmentTracker;
 
 static constexpr int FASTA_LWIDTH = 60;
+/** Bytes of formatted fasta accumulated before getting written */
+static constexpr std::size_t FASTA_WRITE_BUFFER_SIZE = 1 << 20;
+
 class Fasta {
   std::string ID{""}, desc{""};
   std::string sequence;
 
  public:
-  std::string const& get_sequence() { return sequence; }
+  std::string const& get_sequence() const { return sequence; }
+  std::string const& get_ID() const { return ID; }
   void set_ID(std::string new_ID) { this->ID = new_ID; }
   void set_desc(std::string new_desc) { this->desc = new_desc; }
+  void reserve(std::size_t size) { sequence.reserve(size); }
   void add_sequence(std::string const& seq) { sequence += seq; }
+  /** Appends `length` characters of `seq` from `start`, without copying */
+  void add_sequence(std::string const& seq, std::size_t start,
+                    std::size_t length) {
+    sequence.append(seq, start, length);
+  }
+
+  /** The '>' line, newline included */
+  std::string header_line() const;
 
   friend bool operator<(const Fasta& first, const Fasta& second);
   friend std::ostream& operator<<(std::ostream& out_stream, const Fasta& input);
@@ -29,6 +44,10 @@ class Fasta {
 using Fastas = std::vector<Fasta>;
 using unique_Fastas = std::set<Fasta>;
 
+class FastaWriteException : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
 class InconsistentPloidyException : public std::exception {
  public:
   InconsistentPloidyException() {}
@@ -37,13 +56,37 @@ class InconsistentPloidyException : public std::exception {
   }
 };
 
+/** The genotype pasted into the personalised reference(s): REF if null */
+GtypedIndices get_genotype_to_paste(gt_site_ptr const& site,
+                                    std::size_t ploidy);
 allele_vector get_all_alleles_to_paste(gt_site_ptr const& site,
                                        std::size_t ploidy);
+/**
+ * Pastes the genotyped alleles of the sites not nested in any other between
+ * the invariant sequences of the graph, making one Fasta per segment and
+ * haplotype. The sizes of the Fastas get computed first, so that each
+ * sequence is allocated once.
+ */
 Fastas get_personalised_ref(covG_ptr graph_root,
                             gt_sites const& genotyped_records,
                             SegmentTracker& tracker);
 
 void add_description(Fastas& p_refs, std::string const& desc);
+
+/**
+ * Keeps the first of the Fastas with the same sequence, in order.
+ * Sequences are compared by hash, and fully only when hashes are equal.
+ */
+Fastas dedupe_sequences(Fastas fastas);
+
+/**
+ * Writes `fastas` to `fpath`, along with a samtools-style `fpath.fai` index.
+ * If `bgzip`, the file gets compressed by `num_threads` threads and also gets
+ * a `fpath.gzi` index, as made by `bgzip -i`. Indexed files let downstream
+ * tools (eg aligners) skip their own indexing pass.
+ */
+void write_fastas(Fastas const& fastas, std::string const& fpath,
+                  bool bgzip = false, std::size_t num_threads = 1);
 }  // namespace gram::genotype
 
 #endif  // GRAM_PERSONALISED_REF_H
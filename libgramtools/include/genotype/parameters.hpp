@@ -11,6 +11,11 @@
 
 namespace gram {
 enum class Ploidy { Haploid, Diploid };
+/**
+ * What to do with reads mapping to more than `max_read_occurrences` places:
+ * keep an evenly spread subset of their occurrences, or skip them.
+ */
+enum class RepetitiveReadsPolicy { Downsample, Skip };
 using SeedSize = uint32_t;
 using Seed = std::optional<SeedSize>;
 using Seeds = std::vector<SeedSize>;
@@ -23,16 +28,31 @@ class GenotypeParams : public CommonParameters {
   std::string allele_base_coverage_fpath;
   std::string grouped_allele_counts_fpath;
   std::string read_stats_fpath;
+  std::string coverage_checkpoint_fpath; /**< Written after read mapping */
+  bool gzip_coverage = false; /**< gzip the coverage files above */
+
+  /** If non-empty, coverage is loaded from this checkpoint instead of mapping
+   * reads */
+  std::string input_checkpoint_fpath;
+  bool stop_after_mapping = false; /**< Skip genotyping */
 
   Ploidy ploidy;
   std::string sample_id;
   std::string genotyped_json_fpath;
   std::string genotyped_vcf_fpath;
   std::string personalised_ref_fpath;
+  bool bgzip_personalised_ref = false; /**< Also gets a .gzi index */
 
   std::string debug_fpath;
+  /** If non-empty, simulated genotype confidences are cached here */
+  std::string gcp_cache_dirpath;
+  /** If non-empty, the genotyped samples get appended to this store */
+  std::string genotype_store_dirpath;
 
   Seed seed = std::nullopt;
+
+  uint64_t max_read_occurrences = 0; /**< 0 means no cap */
+  RepetitiveReadsPolicy repetitive_reads_policy = RepetitiveReadsPolicy::Skip;
 };
 
 namespace commands::genotype {
@@ -5,7 +5,9 @@
 #ifndef GRAMTOOLS_ALLELE_BASE_HPP
 #define GRAMTOOLS_ALLELE_BASE_HPP
 
+#include <initializer_list>
 #include <optional>
+#include <unordered_map>
 
 #include "genotype/parameters.hpp"
 #include "genotype/quasimap/coverage/types.hpp"
@@ -44,6 +46,13 @@ void allele_base(const Coverage& coverage, const GenotypeParams& parameters);
 }  // namespace dump
 }  // namespace coverage
 
+/**
+ * Serialises all base-level coverages for all sites of the prg in JSON format,
+ * writing each site as it goes.
+ */
+void write_allele_base_coverage(std::ostream& out,
+                                const SitesAlleleBaseCoverage& sites);
+
 std::string dump_allele_base_coverage(const SitesAlleleBaseCoverage& sites);
 
 /**
@@ -115,11 +124,56 @@ class DummyCovNode {
   std::size_t node_size;
 };
 
+/**
+ * Non-owning handle to a `coverage_Node`. Traversals hold these rather than
+ * `covG_ptr`s, so that walking the graph from several threads does not
+ * touch the nodes' shared reference counts.
+ */
+using covG_raw_ptr = coverage_Node*;
+
 /**
  * Ties together a `coverage_Node` to the `DummyCovNode` representing which of
  * its bases need coverage incremented.
+ * A read usually only touches a handful of nodes, so this is a flat vector with
+ * linear lookup. Past `linear_find_max_entries` entries (eg a read with many
+ * mapping instances), lookups go through a hash index into the vector instead.
+ * It is cleared, keeping its capacity, between reads.
  */
-using realCov_to_dummyCov = std::map<covG_ptr, DummyCovNode>;
+class realCov_to_dummyCov {
+ public:
+  using entry = std::pair<covG_raw_ptr, DummyCovNode>;
+
+  realCov_to_dummyCov() = default;
+  realCov_to_dummyCov(std::initializer_list<entry> entries) {
+    for (auto const& entry : entries) insert(entry.first, entry.second);
+  }
+
+  /** @return the `DummyCovNode` of `node`, or nullptr if there is none. */
+  DummyCovNode* find(coverage_Node const* node);
+  DummyCovNode const* find(coverage_Node const* node) const;
+  void insert(covG_raw_ptr node, DummyCovNode const& dummy_node);
+  void clear() {
+    entries.clear();
+    index.clear();
+  }
+  std::size_t size() const { return entries.size(); }
+
+  std::vector<entry>::const_iterator begin() const { return entries.begin(); }
+  std::vector<entry>::const_iterator end() const { return entries.end(); }
+
+  /** Order-insensitive comparison */
+  bool operator==(realCov_to_dummyCov const& other) const;
+
+  static constexpr std::size_t linear_find_max_entries{16};
+
+ private:
+  /** @return the position of `node` in `entries`, or `entries.size()`. */
+  std::size_t find_position(coverage_Node const* node) const;
+
+  std::vector<entry> entries;
+  /** Position of each node in `entries`; only filled past the linear limit */
+  std::unordered_map<coverage_Node const*, std::size_t> index;
+};
 
 /**
  * Class which produces all coverage node from the coverage graph that are in
@@ -134,10 +188,14 @@ class Traverser {
  public:
   Traverser() {}
 
-  Traverser(node_access start_point, VariantSitePath traversed_loci,
-            std::size_t read_size);
+  /**
+   * @param traversed_loci is referred to, not copied, and must outlive the
+   * `Traverser`.
+   */
+  Traverser(node_access const& start_point,
+            VariantSitePath const& traversed_loci, std::size_t read_size);
 
-  std::optional<covG_ptr> next_Node();
+  std::optional<covG_raw_ptr> next_Node();
 
   /*
    * Getters
@@ -174,9 +232,9 @@ class Traverser {
   void choose_allele();
 
  private:
-  covG_ptr cur_Node;
+  covG_raw_ptr cur_Node;
   std::size_t bases_remaining;
-  VariantSitePath traversed_loci;
+  VariantSitePath const* traversed_loci;
   uint32_t traversed_index;
   bool first_node;
   node_coordinate start_pos;
@@ -186,12 +244,18 @@ class Traverser {
 /**
  * Uses `Traverser` to collect per-base coverage implied by search_states and
  * add the coverage to the `coverage_Graph`.
+ * A single recorder can be reused across reads via `record()`, which recycles
+ * its `DummyCovNode` storage.
  */
 class PbCovRecorder {
  public:
   PbCovRecorder(PRG_Info const& prg_info, SearchStates const& search_states,
                 std::size_t read_size);
 
+  /** Records the per-base coverage of one read's `SearchStates`. */
+  void record(PRG_Info const& prg_info, SearchStates const& search_states,
+              std::size_t read_size);
+
   // Testing-related constructors
   PbCovRecorder() = default;
   PbCovRecorder(realCov_to_dummyCov existing_cov_mapping)
@@ -206,16 +270,16 @@ class PbCovRecorder {
    * Creates of extends a `DummyCovNode` based on the `Traverser`'s currently
    * traversed `coverage_Node` in the `coverage_Graph`.
    */
-  void process_Node(covG_ptr cov_node, node_coordinate start_pos,
+  void process_Node(covG_raw_ptr cov_node, node_coordinate start_pos,
                     node_coordinate end_pos);
   void write_coverage_from_dummy_nodes();
 
-  realCov_to_dummyCov get_cov_mapping() const { return cov_mapping; }
+  realCov_to_dummyCov const& get_cov_mapping() const { return cov_mapping; }
 
  private:
   realCov_to_dummyCov cov_mapping;
-  PRG_Info const* prg_info;
-  std::size_t read_size;
+  PRG_Info const* prg_info = nullptr;
+  std::size_t read_size = 0;
 };
 }  // namespace gram::coverage::per_base
 #endif  // GRAMTOOLS_ALLELE_BASE_HPP
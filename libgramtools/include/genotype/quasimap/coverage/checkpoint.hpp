@@ -0,0 +1,92 @@
+/** @file
+ * Defines a binary coverage checkpoint: all the coverage recorded by
+ * `quasimap` plus the `ReadStats` needed by `infer`, so that genotyping can be
+ * re-run without re-mapping reads.
+ *
+ * The checkpoint holds allele sum coverage, grouped allele counts, and the
+ * per-base coverage of each `coverage_Node`. Nodes are not serialised: their
+ * coverage is stored in the order of first appearance in the PRG, so a
+ * checkpoint can only be loaded against the PRG it was made from.
+ */
+
+#ifndef GRAMTOOLS_COVERAGE_CHECKPOINT_HPP
+#define GRAMTOOLS_COVERAGE_CHECKPOINT_HPP
+
+#include "genotype/quasimap/coverage/types.hpp"
+#include "genotype/read_stats.hpp"
+#include "prg/prg_info.hpp"
+
+namespace gram {
+/** Increment when the checkpoint layout changes. */
+constexpr uint32_t coverage_checkpoint_version = 1;
+
+class IncompatibleCheckpoint : public std::exception {
+ public:
+  IncompatibleCheckpoint(std::string msg) : msg(msg) { ; }
+  const char *what() const throw() { return msg.c_str(); }
+
+ private:
+  std::string msg;
+};
+
+/**
+ * @return the `coverage_Node`s recording per-base coverage, in the order in
+ * which they first appear in the PRG.
+ */
+std::vector<coverage_Node *> coverage_nodes(coverage_Graph const &cov_graph);
+
+/** Adds coverage counts, saturating at the maximum `CovCount`. */
+inline CovCount saturating_add(CovCount first, CovCount second) {
+  uint32_t sum = uint32_t{first} + second;
+  return sum > UINT16_MAX ? UINT16_MAX : static_cast<CovCount>(sum);
+}
+
+/**
+ * The contents of a checkpoint, independent of any loaded PRG.
+ * Used to combine checkpoints made from different read sets on the same PRG.
+ */
+struct CoverageCheckpoint {
+  AlleleSumCoverage allele_sum_coverage;
+  SitesGroupedAlleleCounts grouped_allele_counts;
+  std::vector<PerBaseCoverage> node_coverages; /**< @see coverage_nodes() */
+  ReadStats read_stats;
+
+  /**
+   * Adds the coverage of `other` to this one, saturating like `CovCount`.
+   * @throws IncompatibleCheckpoint if the two were made from different PRGs.
+   */
+  void merge(CoverageCheckpoint const &other);
+};
+
+CoverageCheckpoint read_checkpoint(std::string const &fpath);
+void write_checkpoint(std::string const &fpath,
+                      CoverageCheckpoint const &checkpoint);
+
+namespace coverage {
+namespace dump {
+/**
+ * Writes coverage, the per-base coverage of the `coverage_Graph` and read
+ * statistics to a binary checkpoint.
+ */
+void checkpoint(std::string const &fpath, Coverage const &coverage,
+                coverage_Graph const &cov_graph, ReadStats const &readstats);
+}  // namespace dump
+
+namespace load {
+/**
+ * Reads a checkpoint written by `coverage::dump::checkpoint` or
+ * `write_checkpoint`.
+ * Per-base coverage is loaded into the nodes of `prg_info`'s
+ * `coverage_Graph`, and read statistics into `readstats`. Coverage depth
+ * statistics are recomputed from the loaded coverage, so that merged
+ * checkpoints get correct ones.
+ * @throws IncompatibleCheckpoint if the checkpoint was made from a different
+ * PRG or with a different checkpoint version.
+ */
+Coverage checkpoint(std::string const &fpath, PRG_Info const &prg_info,
+                    ReadStats &readstats);
+}  // namespace load
+}  // namespace coverage
+}  // namespace gram
+
+#endif  // GRAMTOOLS_COVERAGE_CHECKPOINT_HPP
@@ -113,6 +113,13 @@ class LocusFinder {
   info_ptr prg_info;
 };
 
+/**
+ * Finds the level 0 sites a `SearchState` goes through, ie the equivalence
+ * class it belongs to. Unlike `LocusFinder`, this needs only the site markers
+ * in the `SearchState`'s paths, and no suffix array lookups.
+ */
+level0_Sites get_base_sites(SearchState const &search_state, info_ptr prg_info);
+
 /**
  * Models an equivalence class: a list of `SearchState`s that are all compatible
  * with the same level 0 sites. The second member, `uniqueLoci`, is the set of
@@ -157,8 +164,18 @@ class MappingInstanceSelector {
   MappingInstanceSelector(info_ptr prg_info, rand_ptr rand_g)
       : prg_info(prg_info), rand_generator(rand_g) {}
 
+  /**
+   * Dispatches each `SearchState` into `usps`, with full locus resolution.
+   */
   void process_searchstates(SearchStates const &all_ss);
 
+  /**
+   * Dispatches each `SearchState` into `usps` based on `get_base_sites` only,
+   * leaving the `uniqueLoci` empty. These are resolved only for the selected
+   * equivalence class, in `apply_selection`.
+   */
+  void partition_searchstates(SearchStates const &all_ss);
+
   void set_searchstates(SearchStates const &ss) { input_search_states = ss; }
 
   /**
@@ -177,6 +194,9 @@ class MappingInstanceSelector {
    */
   int32_t random_select_entry();
 
+  /**
+   * Records the selected equivalence class, resolving its `uniqueLoci`.
+   */
   void apply_selection(int32_t selected_index);
 
   SelectedMapping get_selection() { return selected; }
@@ -69,6 +69,14 @@ GroupIDToAlleles get_group_id_alleles(
 
 JSON get_json(const SitesGroupedAlleleCounts &sites,
               AlleleGroupHash const &allele_ids_groups_hash);
+
+/**
+ * Writes the same JSON as `get_json`, without building it in memory first.
+ * Groups are listed in increasing ID order.
+ */
+void write_grouped_allele_counts(std::ostream &out,
+                                 SitesGroupedAlleleCounts const &sites,
+                                 AlleleGroupHash const &allele_ids_groups_hash);
 }  // namespace gram
 
 #endif  // GRAMTOOLS_GROUPED_ALLELE_COUNTS_HPP
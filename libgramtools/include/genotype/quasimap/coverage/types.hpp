@@ -5,6 +5,14 @@
 #ifndef GRAMTOOLS_COVERAGE_TYPES_HPP
 #define GRAMTOOLS_COVERAGE_TYPES_HPP
 
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
+
 #include "common/data_types.hpp"
 #include "common/utils.hpp"
 
@@ -17,14 +25,160 @@ using AlleleSumCoverage =
 /** Vector of `gram::AlleleId`. Used to store different alleles of the same
  * variant site both by a read.*/
 using AlleleIds = std::vector<AlleleId>;
-/* An unordered_map associating a group of alleles (`gram::AlleleIds`) with a
- * count of how many reads mapped to this group.*/
-using GroupedAlleleCounts = SequenceHashMap<AlleleIds, CovCount>;
+
+/**
+ * A set of alleles of one variant site, compatible with a single read.
+ * Allele IDs below 64 are stored as bits of a single word, so that recording
+ * and hashing a group needs no heap allocation. Sites with wider allele IDs
+ * fall back to a sorted `gram::AlleleIds`.
+ * Iteration yields allele IDs in increasing order.
+ */
+class AlleleGroup {
+ public:
+  static constexpr AlleleId mask_width = 64;
+
+  AlleleGroup() = default;
+  AlleleGroup(AlleleIds const &ids) {
+    for (auto const &id : ids) insert(id);
+  }
+  AlleleGroup(std::initializer_list<AlleleId> ids) {
+    for (auto const &id : ids) insert(id);
+  }
+
+  void insert(AlleleId id) {
+    if (wide_ids.empty() && id < mask_width) {
+      mask |= uint64_t{1} << id;
+      return;
+    }
+    if (wide_ids.empty()) {
+      wide_ids = to_ids();
+      mask = 0;
+    }
+    auto pos = std::lower_bound(wide_ids.begin(), wide_ids.end(), id);
+    if (pos == wide_ids.end() || *pos != id) wide_ids.insert(pos, id);
+  }
+
+  bool contains(AlleleId id) const {
+    if (wide_ids.empty())
+      return id < mask_width && ((mask >> id) & uint64_t{1});
+    return std::binary_search(wide_ids.begin(), wide_ids.end(), id);
+  }
+
+  std::size_t size() const {
+    if (wide_ids.empty()) return __builtin_popcountll(mask);
+    return wide_ids.size();
+  }
+  bool empty() const { return size() == 0; }
+
+  AlleleIds to_ids() const {
+    if (!wide_ids.empty()) return wide_ids;
+    AlleleIds result;
+    result.reserve(size());
+    for (auto id : *this) result.push_back(id);
+    return result;
+  }
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = AlleleId;
+    using difference_type = std::ptrdiff_t;
+    using pointer = AlleleId const *;
+    using reference = AlleleId;
+
+    const_iterator(uint64_t bits, AlleleId const *wide)
+        : bits(bits), wide(wide) {}
+
+    AlleleId operator*() const {
+      if (wide != nullptr) return *wide;
+      return static_cast<AlleleId>(__builtin_ctzll(bits));
+    }
+    const_iterator &operator++() {
+      if (wide != nullptr)
+        ++wide;
+      else
+        bits &= bits - 1;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto old = *this;
+      ++(*this);
+      return old;
+    }
+    bool operator==(const_iterator const &other) const {
+      return bits == other.bits && wide == other.wide;
+    }
+    bool operator!=(const_iterator const &other) const {
+      return !(*this == other);
+    }
+
+   private:
+    uint64_t bits;
+    AlleleId const *wide;
+  };
+
+  const_iterator begin() const {
+    if (wide_ids.empty()) return {mask, nullptr};
+    return {0, wide_ids.data()};
+  }
+  const_iterator end() const {
+    if (wide_ids.empty()) return {0, nullptr};
+    return {0, wide_ids.data() + wide_ids.size()};
+  }
+
+  bool operator==(AlleleGroup const &other) const {
+    return mask == other.mask && wide_ids == other.wide_ids;
+  }
+  bool operator!=(AlleleGroup const &other) const {
+    return !(*this == other);
+  }
+
+  std::size_t hash() const {
+    if (wide_ids.empty()) return std::hash<uint64_t>{}(mask);
+    return sequence_hash<AlleleIds>{}(wide_ids);
+  }
+
+ private:
+  uint64_t mask = 0;
+  AlleleIds wide_ids; /**< Only used if an allele ID does not fit the mask */
+
+  // Boost serialisation
+  friend class boost::serialization::access;
+  template <typename Archive>
+  void serialize(Archive &ar, const unsigned int /*version*/) {
+    ar &mask;
+    ar &wide_ids;
+  }
+};
+
+inline std::ostream &operator<<(std::ostream &out, AlleleGroup const &group) {
+  out << "{";
+  bool first = true;
+  for (auto id : group) {
+    if (!first) out << ", ";
+    out << id;
+    first = false;
+  }
+  return out << "}";
+}
+
+struct AlleleGroupHasher {
+  std::size_t operator()(AlleleGroup const &group) const {
+    return group.hash();
+  }
+};
+
+template <typename T>
+using AlleleGroupMap = std::unordered_map<AlleleGroup, T, AlleleGroupHasher>;
+
+/* An unordered_map associating a group of alleles (`gram::AlleleGroup`) with
+ * a count of how many reads mapped to this group.*/
+using GroupedAlleleCounts = AlleleGroupMap<CovCount>;
 /** A vector containing unordered_maps of allele group counts.
  * There is one such map per variant site in the prg.*/
 using SitesGroupedAlleleCounts = std::vector<GroupedAlleleCounts>;
 
-using AlleleGroupHash = SequenceHashMap<AlleleIds, uint64_t>;
+using AlleleGroupHash = AlleleGroupMap<uint64_t>;
 
 using SitePbCoverage =
     std::vector<PerBaseCoverage>; /**< `gram::PerBaseCoverage` for each allele
@@ -20,11 +20,46 @@ struct QuasimapReadsStats {
   uint64_t missing_kmer_reads_count = 0;
   uint64_t no_extension_reads_count = 0;
   uint64_t exact_mapped_reads_count = 0;
+  uint64_t repetitive_reads_count = 0; /**< Reads with more occurrences than
+                                          allowed; skipped or downsampled */
   Coverage coverage = {};
 };
 
+/**
+ * Outcome of mapping one orientation of a read. Mapping is kept separate from
+ * coverage recording, so that the mapping of a read sequence can be replayed
+ * for each of its copies.
+ */
+enum class MappingStatus { missing_kmer, no_extension, repetitive, mapped };
+
+struct ReadMapping {
+  MappingStatus status = MappingStatus::missing_kmer;
+  SearchStates search_states = {};
+  bool downsampled = false; /**< Mapped, but only to a subset of occurrences */
+};
+
+/** The mappings of a read and of its reverse complement. */
+struct ForwardReverseMapping {
+  ReadMapping forward = {};
+  ReadMapping reverse = {};
+};
+
+/**
+ * Stores the mapping of each distinct read sequence seen so far. Identical
+ * reads (eg PCR duplicates) then get mapped only once.
+ */
+using MappedReadsCache = SequenceHashMap<Sequence, ForwardReverseMapping>;
+
+/**
+ * Number of distinct (not yet cached) reads mapped per batch, and per OpenMP
+ * task, by `map_reads`. Each read is searched both forward and reverse
+ * complemented, so up to twice this many sequences get searched in lockstep.
+ */
+constexpr std::size_t search_batch_size = 32;
+
 /**
  * For each read file, quasimap reads.
+ * Also estimates the base error rate in `readstats`, from the first reads.
  */
 QuasimapReadsStats quasimap_reads(const GenotypeParams &parameters,
                                   const KmerIndex &kmer_index,
@@ -34,12 +69,28 @@ QuasimapReadsStats quasimap_reads(const GenotypeParams &parameters,
 /**
  * Load and process (ie map) reads from a given read file using a buffer to
  * reduce disk I/O calls
+ * @param master_seed each read's selection seed is derived from this and from
+ * the read's index among all reads processed.
+ * @param readstats records the base qualities of the reads read.
  */
 void handle_read_file(QuasimapReadsStats &quasimap_stats,
                       const std::string &reads_fpath,
                       const GenotypeParams &parameters,
                       const KmerIndex &kmer_index, const PRG_Info &prg_info,
-                      RandomGenerator *const seed_generator);
+                      SeedSize const &master_seed,
+                      MappedReadsCache &mapped_reads_cache,
+                      ReadStats &readstats);
+
+/**
+ * Maps each distinct non-empty read of `reads_buffer` which is not yet in
+ * `mapped_reads_cache`, in parallel, and adds it to the cache.
+ * @return for each read in the buffer, a pointer to its cached mapping; this
+ * is `nullptr` for empty reads.
+ */
+std::vector<ForwardReverseMapping const *> map_distinct_reads(
+    std::vector<Sequence> const &reads_buffer,
+    MappedReadsCache &mapped_reads_cache, const GenotypeParams &parameters,
+    const KmerIndex &kmer_index, const PRG_Info &prg_info);
 
 /**
  * Calls quasimapping routine on a given read (forward mapping), and its reverse
@@ -67,6 +118,37 @@ void quasimap_read(const Sequence &read, Coverage &coverage,
                    const GenotypeParams &parameters, QuasimapReadsStats &stats,
                    SeedSize const &selection_seed = 42);
 
+/**
+ * Maps a read to the prg without recording any coverage.
+ */
+ReadMapping map_read(const Sequence &read, const KmerIndex &kmer_index,
+                     const PRG_Info &prg_info,
+                     const GenotypeParams &parameters);
+
+/**
+ * Batched version of `map_read`: reads are searched together using
+ * `search_reads_backwards`.
+ */
+std::vector<ReadMapping> map_reads(const Sequences &reads,
+                                   const KmerIndex &kmer_index,
+                                   const PRG_Info &prg_info,
+                                   const GenotypeParams &parameters);
+
+ForwardReverseMapping map_forward_reverse(const Sequence &read,
+                                          const KmerIndex &kmer_index,
+                                          const PRG_Info &prg_info,
+                                          const GenotypeParams &parameters);
+
+/**
+ * Records the coverage and mapping statistics of one copy of a mapped read.
+ * Calling this once per copy of a read, each with its own `selection_seed`,
+ * gives the same results as mapping each copy with `quasimap_read`.
+ */
+void record_read_mapping(const ReadMapping &read_mapping,
+                         const uint64_t &read_length, Coverage &coverage,
+                         QuasimapReadsStats &stats, const PRG_Info &prg_info,
+                         SeedSize const &selection_seed);
+
 /**
  * Fetches a kmer of size `kmer_size`, starting from `offset` (0-based)
  * positions to the right of the start of `read`, and reading left-to-right.
@@ -89,6 +171,44 @@ SearchStates search_read_backwards(const Sequence &read, const Sequence &kmer,
                                    const KmerIndex &kmer_index,
                                    const PRG_Info &prg_info);
 
+/**
+ * Batched backward search: the same as `search_read_backwards`, without the
+ * final handling of allele-encapsulated search states. Seeding each read with its
+ * 3'-most kmer of size `kmer_size`. The reads are extended one base at a time
+ * in lockstep: the memory needed by each read's next rank queries is
+ * prefetched before any of them is resolved, so that the FM-index cache misses
+ * of different reads overlap.
+ * @return the `SearchStates` of each read, as `search_read_backwards` would
+ * give them.
+ */
+std::vector<SearchStates> extend_reads_backwards(const Sequences &reads,
+                                                 const uint32_t &kmer_size,
+                                                 const KmerIndex &kmer_index,
+                                                 const PRG_Info &prg_info);
+
+/**
+ * Batched version of `search_read_backwards`.
+ * @see extend_reads_backwards()
+ */
+std::vector<SearchStates> search_reads_backwards(const Sequences &reads,
+                                                 const uint32_t &kmer_size,
+                                                 const KmerIndex &kmer_index,
+                                                 const PRG_Info &prg_info);
+
+/**
+ * The number of places in the prg a read maps to, ie the summed size of the SA
+ * intervals of its `SearchState`s.
+ */
+uint64_t count_occurrences(SearchStates const &search_states);
+
+/**
+ * Keeps `max_occurrences` of the occurrences in `search_states`, evenly spread
+ * over them. This is deterministic, so that all copies of a read keep the same
+ * occurrences.
+ */
+SearchStates downsample_occurrences(SearchStates const &search_states,
+                                    uint64_t const &max_occurrences);
+
 /**
  * **The key read mapping procedure**.
  * First updates SA_intervals to search next based on variant marker presence.
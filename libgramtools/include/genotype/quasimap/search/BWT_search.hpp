@@ -48,6 +48,22 @@ SA_Interval base_next_sa_interval(const Marker &next_char,
                                   const SA_Interval &current_sa_interval,
                                   const PRG_Info &prg_info);
 
+/**
+ * Issues a software prefetch of the bwt mask word read by
+ * `dna_bwt_rank(upper_index, dna_base, prg_info)`. Prefetching for several
+ * reads before resolving any rank query overlaps their memory latencies.
+ */
+void prefetch_dna_bwt_rank(const uint64_t &upper_index, const Marker &dna_base,
+                           const PRG_Info &prg_info);
+
+/**
+ * Prefetches the memory used by `base_next_sa_interval` when extending
+ * `current_sa_interval` with `next_char`.
+ */
+void prefetch_next_sa_interval(const Marker &next_char,
+                               const SA_Interval &current_sa_interval,
+                               const PRG_Info &prg_info);
+
 std::string serialize_search_state(const SearchState &search_state);
 
 std::ostream &operator<<(std::ostream &os, const SearchState &search_state);
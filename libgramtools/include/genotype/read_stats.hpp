@@ -5,6 +5,8 @@
  * recording that, as well as some other usable metrics, such as max read length
  * and number of sites with no coverage.
  */
+#include <boost/serialization/access.hpp>
+
 #include "genotype/quasimap/coverage/types.hpp"
 #include "prg/types.hpp"
 
@@ -81,6 +83,22 @@ class ReadStats : public AbstractReadStats {
    */
   void process_read_perbase_error_rates(AbstractGenomicReadIterator& reads_it);
 
+  /**
+   * Records the length and base qualities of one read, so that reads can be
+   * sampled while they are streamed for mapping. Reads past the first
+   * `NUM_READS_USED` with base qualities are ignored.
+   * Call `finalise_base_error_rate` once all reads have been recorded.
+   */
+  void record_read(GenomicRead const& read);
+
+  /** Whether `record_read` still uses reads. */
+  bool needs_more_reads() const {
+    return num_informative_reads < NUM_READS_USED;
+  }
+
+  /** Computes the error rate from the reads given to `record_read`. */
+  void finalise_base_error_rate();
+
   using haplogroup_cov = std::pair<AlleleId, CovCount>;
 
   static haplogroup_cov get_max_cov_haplogroup(
@@ -92,6 +110,14 @@ class ReadStats : public AbstractReadStats {
 
   void serialise(const std::string& json_output_fpath);
 
+  /**
+   * Combines read-level statistics with those from another set of reads:
+   * the error rate is averaged weighted by number of bases processed.
+   * Coverage depth statistics get reset, as they need recomputing from the
+   * combined coverage.
+   */
+  void combine(ReadStats const& other);
+
   double const& get_mean_pb_error() const { return mean_pb_error; }
   int64_t const& get_num_bases_processed() const { return num_bases_processed; }
   std::size_t const& get_max_read_len() const { return max_read_length; }
@@ -102,6 +128,26 @@ class ReadStats : public AbstractReadStats {
   int64_t no_qual_reads;
   std::size_t max_read_length;
   int64_t num_bases_processed;
+
+  // Running totals of `record_read`
+  uint64_t num_informative_reads = 0;
+  int64_t num_no_qual_recorded = 0;
+  int64_t num_bases_recorded = 0;
+  double running_qual_score = 0;
+
+  // Boost serialisation, used in coverage checkpoints
+  friend class boost::serialization::access;
+  template <typename Archive>
+  void serialize(Archive& ar, const unsigned int /*version*/) {
+    ar& mean_cov_depth;
+    ar& variance_cov_depth;
+    ar& num_sites_noCov;
+    ar& num_sites_total;
+    ar& mean_pb_error;
+    ar& no_qual_reads;
+    ar& max_read_length;
+    ar& num_bases_processed;
+  }
 };
 
 }  // namespace gram
@@ -74,7 +74,7 @@ class coverage_Node {
    * Getters
    */
   std::size_t get_pos() const { return pos; }
-  std::string get_sequence() const { return sequence; }
+  std::string const& get_sequence() const { return sequence; }
   std::size_t get_sequence_size() const { return sequence.size(); }
   int get_coverage_space() const { return coverage.size(); }
   PerBaseCoverage const& get_coverage() const { return coverage; }
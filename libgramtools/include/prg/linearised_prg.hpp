@@ -20,7 +20,13 @@ using namespace gram;
 
 namespace gram {
 enum class endianness { big, little };
-}
+
+/** Number of markers byte-swapped and written at a time */
+constexpr std::size_t PRG_STRING_IO_BLOCK_SIZE{1 << 20};
+
+/** Below this many characters, `encode_prg` uses a single thread */
+constexpr std::size_t ENCODE_PRG_MIN_CHUNK_SIZE{1 << 20};
+}  // namespace gram
 
 /**********************
  * Supporting nesting**
@@ -31,8 +37,8 @@ class PRG_String {
 
   /**
    * Read in PRG String from binary int vector
-   * Reads byte per byte in specified endianness; the serialisor must write that
-   * way too.
+   * The file is read in one go in specified endianness, and byte-swapped if
+   * that is not the machine's; the serialisor must write that way too.
    */
   PRG_String(std::string const &file_in, endianness en = endianness::little);
 
@@ -100,6 +106,7 @@ namespace gram {
  * Nucleotides encoded as 1-4. Variant markers can make up several characters so
  * are treated with a buffer. NB: this function only works for PRGs with no
  * nested variation (otherwise, for eg, '57' confounded with '5' then '7')
+ * Large PRGs are encoded in parallel chunks, split between variant markers.
  */
 marker_vec encode_prg(const std::string &prg_raw);
 }  // namespace gram
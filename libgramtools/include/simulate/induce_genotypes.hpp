@@ -33,7 +33,7 @@ class TooManyEndpoints : public std::runtime_error {
   using std::runtime_error::runtime_error;
 };
 
-class NodeThread : public std::enable_shared_from_this<NodeThread const> {
+class NodeThread {
  public:
   explicit NodeThread(nt_ptr const& input_parent, covG_ptr input_prg_node,
                       int input_offset)
@@ -50,7 +50,6 @@ class NodeThread : public std::enable_shared_from_this<NodeThread const> {
   covG_ptr const& get_prg_node() const { return prg_node; }
   int get_offset() const { return offset; }
   bool has_next() const { return prg_node->get_num_edges() > 0; }
-  void visit(nt_ptr_v& to_visit, std::string const& sequence) const;
 
  private:
   nt_ptr parent;
@@ -64,7 +63,9 @@ class NodeThread : public std::enable_shared_from_this<NodeThread const> {
 gt_sites make_nulled_sites(coverage_Graph const& input_prg);
 
 /**
- * Finds all occurrences of `sequence` in the graph
+ * Finds all occurrences of `sequence` in the graph, by depth-first search
+ * holding only the path being explored. `NodeThread`s only get made for the
+ * paths leading to an endpoint.
  * @return a vector of endpoints, which are vectors of `NodeThread`s
  */
 nt_ptr_v thread_sequence(covG_ptr root, std::string const& sequence);
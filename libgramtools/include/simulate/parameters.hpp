@@ -2,6 +2,7 @@
 #define SIMU_PARAMETERS_HPP
 
 #include "common/parameters.hpp"
+#include "genotype/parameters.hpp"
 
 namespace gram {
 
@@ -11,6 +12,7 @@ class SimulateParams : public CommonParameters {
   std::string sample_id;
   uint64_t max_num_paths;
   std::string input_sequences_fpath;
+  Seed seed = std::nullopt;
 };
 
 namespace commands::simulate {
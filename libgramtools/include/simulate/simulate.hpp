@@ -1,7 +1,10 @@
 #ifndef GRAMTOOLS_SIMULATE_HPP
 #define GRAMTOOLS_SIMULATE_HPP
 
+#include <optional>
+
 #include "common/random.hpp"
+#include "genotype/infer/output_specs/fields.hpp"
 #include "genotype/infer/level_genotyping/runner.hpp"
 #include "parameters.hpp"
 
@@ -10,6 +13,26 @@ using namespace gram::genotype::infer;
 namespace gram::simulate {
 using Seed = uint32_t;
 
+/** Number of paths simulated in parallel before being deduplicated */
+constexpr std::size_t SIMULATED_PATHS_PER_BATCH{1024};
+
+/**
+ * What all paths simulated through a PRG share, built once: its child map,
+ * its sites in genotyping order, and the alleles of the sites with no nested
+ * sites, which do not depend on the simulated genotypes.
+ */
+struct SimulationTemplate {
+  coverage_Graph const *cov_graph;
+  child_map child_m;
+  std::vector<std::pair<covG_ptr, covG_ptr>> bubbles;  // Most nested first
+  /** Indexed like `bubbles`; empty for sites with nested sites */
+  std::vector<std::optional<allele_vector>> fixed_alleles;
+  /** Indices of the sites not nested in any other */
+  std::vector<std::size_t> lvl1_site_indices;
+
+  explicit SimulationTemplate(coverage_Graph const &cov_graph);
+};
+
 class SimulationGenotyper : public LevelGenotyper {
  public:
   /**
@@ -19,6 +42,13 @@ class SimulationGenotyper : public LevelGenotyper {
    */
   SimulationGenotyper(coverage_Graph const &cov_graph);
 
+  /**
+   * Draws genotypes with `rand`. Alleles only get extracted for the sites with
+   * nested sites, as they depend on the genotypes drawn for those.
+   */
+  SimulationGenotyper(SimulationTemplate const &simu_template,
+                      RandomGenerator *const rand);
+
   /**
    * For taking in directly genotyped sites
    */
@@ -35,6 +65,13 @@ class SimulationGenotyper : public LevelGenotyper {
  */
 lvlgt_site_ptr make_randomly_genotyped_site(RandomGenerator *const rand,
                                             allele_vector const &alleles);
+
+/**
+ * The alleles pasted at the sites not nested in any other: they identify the
+ * path taken through the PRG.
+ */
+strings get_lvl1_alleles(gt_sites const &genotyped_records,
+                         std::vector<std::size_t> const &lvl1_site_indices);
 }  // namespace gram::simulate
 
 namespace gram::commands::simulate {
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <boost/iostreams/filtering_streambuf.hpp>
 
 #include "build/check_ref.hpp"
@@ -5,6 +7,70 @@
 
 using namespace boost::iostreams;
 
+namespace {
+/**
+ * Walks the first path of a coverage graph one character at a time, without
+ * materialising it.
+ */
+class FirstPathWalker {
+ public:
+  explicit FirstPathWalker(coverage_Graph const &cov_graph)
+      : node(cov_graph.root) {
+    skip_consumed_nodes();
+  }
+
+  /**
+   * Advances along the path for as long as it matches `seq`.
+   * @return the number of characters of `seq` matched
+   */
+  std::size_t consume(std::string const &seq) {
+    std::size_t matched{0};
+    while (matched < seq.size() && !at_end()) {
+      auto const &node_seq = node->get_sequence();
+      auto const length =
+          std::min(node_seq.size() - pos, seq.size() - matched);
+      auto const first_diff =
+          std::mismatch(node_seq.begin() + pos, node_seq.begin() + pos + length,
+                        seq.begin() + matched);
+      auto const num_equal = static_cast<std::size_t>(
+          first_diff.first - (node_seq.begin() + pos));
+      pos += num_equal;
+      matched += num_equal;
+      skip_consumed_nodes();
+      if (num_equal < length) break;
+    }
+    return matched;
+  }
+
+  /** Reads up to `n` characters ahead, advancing past them */
+  std::string read(std::size_t n) {
+    std::string result;
+    while (result.size() < n && !at_end()) {
+      auto const length =
+          std::min(node->get_sequence_size() - pos, n - result.size());
+      result.append(node->get_sequence(), pos, length);
+      pos += length;
+      skip_consumed_nodes();
+    }
+    return result;
+  }
+
+ private:
+  covG_ptr node;
+  std::size_t pos{0};  // In the sequence of `node`
+
+  /** The sink node's sequence is not part of the path */
+  bool at_end() const { return node->get_num_edges() == 0; }
+
+  void skip_consumed_nodes() {
+    while (!at_end() && pos == node->get_sequence_size()) {
+      node = node->get_edges().at(0);
+      pos = 0;
+    }
+  }
+};
+}  // namespace
+
 gram::PrgRefChecker::PrgRefChecker(std::istream &fasta_ref_handle,
                                    coverage_Graph const &cov_graph,
                                    bool const gzipped) {
@@ -12,19 +78,35 @@ gram::PrgRefChecker::PrgRefChecker(std::istream &fasta_ref_handle,
   input_fasta(in, fasta_ref_handle, gzipped);
   std::istream getter{&in};
 
-  std::string prg_first_path = get_first_prg_path(cov_graph);
-  uint32_t prg_offset{0};
-  std::string line, ref_seq;
-  while (std::getline(getter, line)) {
-    if (line[0] == '>') continue;
-    ref_seq += line;
-    auto prg_slice = prg_first_path.substr(prg_offset, line.size());
-    if (prg_slice != line) {
-      throw std::runtime_error("Reference sequence " + line +
-                               " does not match prg slice " + prg_slice +
-                               " from position " + std::to_string(prg_offset));
+  FirstPathWalker prg_path(cov_graph);
+  uint64_t prg_offset{0};
+  std::vector<char> buffer(REF_CHECK_BUFFER_SIZE);
+  std::string ref_seq;  // The sequence characters of one buffer
+  ref_seq.reserve(REF_CHECK_BUFFER_SIZE);
+  bool line_start{true}, in_header{false};
+  while (getter.read(buffer.data(), buffer.size()), getter.gcount() > 0) {
+    ref_seq.clear();
+    for (std::streamsize i = 0; i < getter.gcount(); ++i) {
+      auto const c = buffer[i];
+      if (c == '\n') {
+        line_start = true;
+        in_header = false;
+        continue;
+      }
+      if (line_start && c == '>') in_header = true;
+      line_start = false;
+      if (!in_header) ref_seq.push_back(c);
+    }
+
+    auto const matched = prg_path.consume(ref_seq);
+    if (matched < ref_seq.size()) {
+      auto const ref_slice = ref_seq.substr(matched, 60);
+      auto const prg_slice = prg_path.read(ref_slice.size());
+      throw std::runtime_error(
+          "Reference sequence " + ref_slice + " does not match prg slice " +
+          prg_slice + " from position " + std::to_string(prg_offset + matched));
     }
-    prg_offset += line.size();
+    prg_offset += matched;
   }
   assert(prg_offset > 0);
 }
@@ -0,0 +1,10 @@
+#include "common/file_write.hpp"
+
+#include <boost/iostreams/filter/gzip.hpp>
+
+OutputFile::OutputFile(std::string const &fpath, bool gzipped) {
+  file.open(fpath, std::ios::binary);
+  if (!file) throw std::runtime_error("Could not write to " + fpath);
+  if (gzipped) out.push(boost::iostreams::gzip_compressor(), buffer_size);
+  out.push(file, buffer_size);
+}
@@ -17,4 +17,34 @@ uint32_t RandomInclusiveInt::generate(uint32_t min, uint32_t max) {
   std::uniform_int_distribution<uint32_t> range(min, max);
   return range(random_number_generator);
 }
+
+uint64_t CounterRandomInt::next() {
+  state += 0x9e3779b97f4a7c15;
+  uint64_t z = state;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+uint32_t CounterRandomInt::generate(uint32_t min, uint32_t max) {
+  uint64_t const range = uint64_t{max} - min + 1;
+  if (range > std::numeric_limits<uint32_t>::max()) return (*this)();
+  // Unbiased mapping of a 32-bit draw to [0, range): multiply and keep the
+  // high bits, rejecting the few draws that would favour some values
+  // (D. Lemire, "Fast random integer generation in an interval", 2019)
+  while (true) {
+    uint64_t const product = (next() >> 32) * range;
+    uint32_t const low_bits = product;
+    if (low_bits < range) {
+      uint32_t const threshold = (uint32_t(0) - uint32_t(range)) % range;
+      if (low_bits < threshold) continue;
+    }
+    return min + static_cast<uint32_t>(product >> 32);
+  }
+}
+
+SeedSize derive_seed(SeedSize const &master_seed, uint64_t const &index) {
+  CounterRandomInt generator{(uint64_t{master_seed} << 32) ^ index};
+  return generator();
+}
 }  // namespace gram
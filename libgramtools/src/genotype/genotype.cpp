@@ -3,68 +3,89 @@
 #include "build/kmer_index/load.hpp"
 #include "common/timer_report.hpp"
 #include "genotype/infer/level_genotyping/runner.hpp"
+#include "genotype/infer/output_specs/genotype_store.hpp"
 #include "genotype/infer/output_specs/make_json.hpp"
 #include "genotype/infer/output_specs/make_vcf.hpp"
 #include "genotype/infer/output_specs/segment_tracker.hpp"
 #include "genotype/infer/personalised_reference.hpp"
+#include "genotype/quasimap/coverage/checkpoint.hpp"
 #include "genotype/quasimap/quasimap.hpp"
 
 using namespace gram;
 using namespace gram::genotype;
 
-namespace gram::genotype {
-void write_deduped_p_refs(Fastas const& p_refs, std::string const& fpath) {
-  unique_Fastas deduped_p_refs{p_refs.begin(), p_refs.end()};
-  std::ofstream pers_ref_fhandle(fpath);
-  for (auto& p_ref : deduped_p_refs) pers_ref_fhandle << p_ref << std::endl;
-  pers_ref_fhandle.close();
-}
-}  // namespace gram::genotype
-
 void gram::commands::genotype::run(GenotypeParams const& parameters,
                                    bool const& debug) {
   auto timer = TimerReport();
-  /**
-   * Quasimap
-   */
   std::cout << "Executing genotype command" << std::endl;
 
+  // Base error rate gets estimated while reads are mapped
   ReadStats readstats;
-  std::string first_reads_fpath = parameters.reads_fpaths[0];
-  readstats.compute_base_error_rate(first_reads_fpath);
+  bool const from_checkpoint = !parameters.input_checkpoint_fpath.empty();
 
   timer.start("Load data");
   std::cout << "Loading PRG data" << std::endl;
   const auto prg_info = load_prg_info(parameters);
-  std::cout << "Loading kmer index data" << std::endl;
-  const auto kmer_index = kmer_index::load(parameters);
+  KmerIndex kmer_index;
+  if (!from_checkpoint) {
+    std::cout << "Loading kmer index data" << std::endl;
+    kmer_index = kmer_index::load(parameters);
+  }
   timer.stop();
 
-  std::cout << "Running quasimap" << std::endl;
-  timer.start("Quasimap");
-  auto quasimap_stats =
-      quasimap_reads(parameters, kmer_index, prg_info, readstats);
+  Coverage coverage;
+  if (from_checkpoint) {
+    timer.start("Load coverage");
+    std::cout << "Loading coverage checkpoint "
+              << parameters.input_checkpoint_fpath << std::endl;
+    coverage = coverage::load::checkpoint(parameters.input_checkpoint_fpath,
+                                          prg_info, readstats);
+    timer.stop();
+  } else {
+    /**
+     * Quasimap
+     */
+    std::cout << "Running quasimap" << std::endl;
+    timer.start("Quasimap");
+    auto quasimap_stats =
+        quasimap_reads(parameters, kmer_index, prg_info, readstats);
+    coverage = std::move(quasimap_stats.coverage);
+
+    std::cout << std::endl;
+    std::cout
+        << "The following counts include generated reverse complement reads."
+        << std::endl;
+    std::cout << "Count all reads: " << quasimap_stats.all_reads_count
+              << std::endl;
+    std::cout << "Count skipped reads with no sequence: "
+              << quasimap_stats.skipped_reads_count << std::endl;
+    std::cout << "Count reads with >0 kmers not in kmer index: "
+              << quasimap_stats.missing_kmer_reads_count << std::endl;
+    std::cout << "Count reads with no exact mapping: "
+              << quasimap_stats.no_extension_reads_count << std::endl;
+    std::cout << "Count exact mapped reads: "
+              << quasimap_stats.exact_mapped_reads_count << std::endl;
+    if (parameters.max_read_occurrences > 0)
+      std::cout << "Count repetitive reads (>"
+                << parameters.max_read_occurrences << " occurrences): "
+                << quasimap_stats.repetitive_reads_count << std::endl;
+
+    std::cout << "Writing coverage checkpoint to "
+              << parameters.coverage_checkpoint_fpath << std::endl;
+    coverage::dump::checkpoint(parameters.coverage_checkpoint_fpath, coverage,
+                               prg_info.coverage_graph, readstats);
+    timer.stop();
+  }
 
   // Commit the read stats into quasimap output dir.
   std::cout << "Writing read stats to " << parameters.read_stats_fpath
             << std::endl;
   readstats.serialise(parameters.read_stats_fpath);
 
-  std::cout << std::endl;
-  std::cout
-      << "The following counts include generated reverse complement reads."
-      << std::endl;
-  std::cout << "Count all reads: " << quasimap_stats.all_reads_count
-            << std::endl;
-  std::cout << "Count skipped reads with no sequence: "
-            << quasimap_stats.skipped_reads_count << std::endl;
-  std::cout << "Count reads with >0 kmers not in kmer index: "
-            << quasimap_stats.missing_kmer_reads_count << std::endl;
-  std::cout << "Count reads with no exact mapping: "
-            << quasimap_stats.no_extension_reads_count << std::endl;
-  std::cout << "Count exact mapped reads: "
-            << quasimap_stats.exact_mapped_reads_count << std::endl;
-  timer.stop();
+  if (parameters.stop_after_mapping) {
+    timer.report();
+    return;
+  }
 
   /**
    * Infer
@@ -83,11 +104,12 @@ void gram::commands::genotype::run(GenotypeParams const& parameters,
 
   std::cout << "Running genotyping model" << std::endl;
   LevelGenotyper genotyper{prg_info.coverage_graph,
-                           quasimap_stats.coverage.grouped_allele_counts,
+                           coverage.grouped_allele_counts,
                            readstats,
                            parameters.ploidy,
                            true,
-                           debug_file};
+                           debug_file,
+                           parameters.gcp_cache_dirpath};
 
   std::ifstream coords_file(parameters.prg_coords_fpath);
   SegmentTracker tracker(coords_file);
@@ -96,12 +118,19 @@ void gram::commands::genotype::run(GenotypeParams const& parameters,
   std::cout << "Producing json vcf" << std::endl;
   std::ofstream geno_json_fhandle(parameters.genotyped_json_fpath);
   auto gtyper = std::make_shared<LevelGenotyper>(genotyper);
-  auto sample_json = make_json_prg(gtyper, tracker);
-  sample_json->set_sample_info(parameters.sample_id,
-                               "made by gramtools genotype");
-  geno_json_fhandle << sample_json->get_prg() << std::endl;
+  write_json_prg(geno_json_fhandle, gtyper, tracker, parameters.sample_id,
+                 "made by gramtools genotype");
+  geno_json_fhandle << std::endl;
   geno_json_fhandle.close();
 
+  if (!parameters.genotype_store_dirpath.empty()) {
+    std::cout << "Appending to genotype store "
+              << parameters.genotype_store_dirpath << std::endl;
+    std::ifstream geno_json_in(parameters.genotyped_json_fpath);
+    JsonSiteReader reader(geno_json_in, parameters.genotyped_json_fpath);
+    GenotypeStore(parameters.genotype_store_dirpath).append(reader);
+  }
+
   std::cout << "Producing personalised reference" << std::endl;
   auto sites = genotyper.get_genotyped_records();
   tracker.reset();
@@ -111,7 +140,9 @@ void gram::commands::genotype::run(GenotypeParams const& parameters,
                      " personalised reference made by gramtools genotype";
   add_description(p_refs, desc);
 
-  write_deduped_p_refs(p_refs, parameters.personalised_ref_fpath);
+  write_fastas(dedupe_sequences(std::move(p_refs)),
+               parameters.personalised_ref_fpath,
+               parameters.bgzip_personalised_ref, parameters.maximum_threads);
 
   std::cout << "Producing vcf" << std::endl;
   tracker.reset();
@@ -7,6 +7,43 @@
 
 using namespace gram::genotype::infer;
 
+void AlleleRope::append(coverage_Node const& node) {
+  segments.push_back(Segment{&node, nullptr});
+  length += node.get_sequence_size();
+}
+
+void AlleleRope::append(Allele const& allele) {
+  segments.push_back(Segment{nullptr, &allele});
+  length += allele.sequence.size();
+  callable &= allele.callable;
+}
+
+Allele AlleleRope::materialise() const {
+  Allele result{"", {}, haplogroup, callable};
+  result.sequence.reserve(length);
+  result.pbCov.reserve(length);
+  for (auto const& segment : segments) {
+    if (segment.node != nullptr) {
+      auto const& coverage = segment.node->get_coverage();
+      result.sequence += segment.node->get_sequence();
+      result.pbCov.insert(result.pbCov.end(), coverage.begin(), coverage.end());
+    } else {
+      auto const& allele = *segment.allele;
+      result.sequence += allele.sequence;
+      result.pbCov.insert(result.pbCov.end(), allele.pbCov.begin(),
+                          allele.pbCov.end());
+    }
+  }
+  return result;
+}
+
+allele_vector gram::genotype::infer::materialise(rope_vector const& ropes) {
+  allele_vector result;
+  result.reserve(ropes.size());
+  for (auto const& rope : ropes) result.push_back(rope.materialise());
+  return result;
+}
+
 AlleleExtracter::AlleleExtracter(covG_ptr site_start, covG_ptr site_end,
                                  gt_sites& sites)
     : genotyped_sites(&sites) {
@@ -22,8 +59,8 @@ AlleleExtracter::AlleleExtracter(covG_ptr site_start, covG_ptr site_end,
   }
 }
 
-allele_vector AlleleExtracter::allele_combine(allele_vector const& existing,
-                                              std::size_t site_index) {
+rope_vector AlleleExtracter::allele_combine(rope_vector const& existing,
+                                            std::size_t site_index) {
   // Sanity check: site_index refers to actual site
   assert(0 <= site_index && site_index < genotyped_sites->size());
   gt_site_ptr referent_site = genotyped_sites->at(site_index);
@@ -44,23 +81,28 @@ allele_vector AlleleExtracter::allele_combine(allele_vector const& existing,
   while (existing.size() * relevant_alleles.size() > MAX_COMBINATIONS)
     relevant_alleles.resize(relevant_alleles.size() - 1);
 
-  allele_vector combinations(existing.size() * relevant_alleles.size());
+  // Ropes point into `nested_alleles`, whose elements never move
+  std::vector<Allele const*> added_alleles;
+  added_alleles.reserve(relevant_alleles.size());
+  for (auto& allele : relevant_alleles) {
+    nested_alleles.push_back(std::move(allele));
+    added_alleles.push_back(&nested_alleles.back());
+  }
 
-  std::size_t insertion_index{0};
-  for (auto const& allele : existing) {
-    for (auto const& added_allele : relevant_alleles) {
-      combinations.at(insertion_index) = allele + added_allele;
-      ++insertion_index;
+  rope_vector combinations;
+  combinations.reserve(existing.size() * added_alleles.size());
+  for (auto const& rope : existing) {
+    for (auto const added_allele : added_alleles) {
+      combinations.push_back(rope);
+      combinations.back().append(*added_allele);
     }
   }
   return combinations;
 }
 
-void AlleleExtracter::allele_paste(allele_vector& existing,
+void AlleleExtracter::allele_paste(rope_vector& existing,
                                    covG_ptr sequence_node) {
-  Allele to_paste_allele{sequence_node->get_sequence(),
-                         sequence_node->get_coverage()};
-  for (auto& allele : existing) allele = allele + to_paste_allele;
+  for (auto& rope : existing) rope.append(*sequence_node);
 }
 
 void AlleleExtracter::place_ref_as_first_allele(allele_vector& alleles,
@@ -75,37 +117,34 @@ void AlleleExtracter::place_ref_as_first_allele(allele_vector& alleles,
 
 Allele gram::genotype::infer::extract_ref_allele(covG_ptr start_node,
                                                  covG_ptr end_node) {
-  Allele result{"", {}, 0};
+  AlleleRope result{0};
   covG_ptr cur_Node{start_node};
 
   while (cur_Node != end_node) {
-    if (cur_Node->has_sequence()) {
-      result =
-          result + Allele{cur_Node->get_sequence(), cur_Node->get_coverage()};
-    }
+    if (cur_Node->has_sequence()) result.append(*cur_Node);
     cur_Node = *(cur_Node->get_edges().begin());
   }
-  return result;
+  return result.materialise();
 }
 
 allele_vector AlleleExtracter::extract_alleles(AlleleId const haplogroup,
                                                covG_ptr haplogroup_start,
                                                covG_ptr site_end) {
-  allele_vector haplogroup_alleles{
-      {"", {}, haplogroup}};  // Make one empty allele as starting point, allows
-                              // for direct deletion
+  rope_vector haplogroup_ropes{
+      AlleleRope{haplogroup}};  // Make one empty allele as starting point,
+                                // allows for direct deletion
   covG_ptr cur_Node{haplogroup_start};
 
   while (cur_Node != site_end) {
     if (cur_Node->is_bubble_start()) {
       auto site_index = siteID_to_index(cur_Node->get_site_ID());
-      haplogroup_alleles = allele_combine(haplogroup_alleles, site_index);
+      haplogroup_ropes = allele_combine(haplogroup_ropes, site_index);
 
       auto referent_site = genotyped_sites->at(site_index);
       cur_Node =
           referent_site->get_site_end_node();  // Move past site, to bubble end
     } else {
-      allele_paste(haplogroup_alleles, cur_Node);
+      allele_paste(haplogroup_ropes, cur_Node);
     }
 
     // The only nodes with >1 neighbour are bubble starts and we
@@ -115,6 +154,7 @@ allele_vector AlleleExtracter::extract_alleles(AlleleId const haplogroup,
     cur_Node = *(cur_Node->get_edges().begin());  // Advance to the next node
   }
 
+  auto haplogroup_alleles = materialise(haplogroup_ropes);
   if (haplogroup == 0) {
     auto ref_allele = extract_ref_allele(haplogroup_start, site_end);
     place_ref_as_first_allele(haplogroup_alleles, ref_allele);
@@ -1,5 +1,7 @@
 #include "genotype/infer/level_genotyping/model.hpp"
 
+#include <limits>
+
 #include "genotype/infer/allele_extracter.hpp"
 
 using namespace gram::genotype::infer;
@@ -65,7 +67,7 @@ void LevelGenotyperModel::set_haploid_coverages(
       haploid_allele_coverages.at(allele_id) += entry.second;
     }
     if (entry.first.size() == 1) {
-      AlleleId id{entry.first.at(0)};
+      AlleleId id{*entry.first.begin()};
       singleton_allele_coverages.at(id) = entry.second;
     }
   }
@@ -101,10 +103,8 @@ std::pair<double, double> LevelGenotyperModel::diploid_cov_different_haplogroup(
   CovCount shared_coverage{0};
 
   for (auto const& entry : gp_counts) {
-    has_first_allele = std::find(entry.first.begin(), entry.first.end(),
-                                 allele_1_id) != entry.first.end();
-    has_second_allele = std::find(entry.first.begin(), entry.first.end(),
-                                  allele_2_id) != entry.first.end();
+    has_first_allele = entry.first.contains(allele_1_id);
+    has_second_allele = entry.first.contains(allele_2_id);
     if (has_first_allele && has_second_allele) shared_coverage += entry.second;
   }
 
@@ -240,6 +240,13 @@ std::vector<GtypedIndices> LevelGenotyperModel::get_permutations(
 void LevelGenotyperModel::add_likelihood(allele_vector const& alleles,
                                          double const& incompatible_coverage,
                                          GtypedIndices const& allele_indices) {
+  assert(allele_indices.size() == alleles.size());
+  likelihoods.insert(
+      {compute_likelihood(alleles, incompatible_coverage), allele_indices});
+}
+
+double LevelGenotyperModel::compute_likelihood(
+    allele_vector const& alleles, double const& incompatible_coverage) {
   double log_likelihood =
       incompatible_coverage * data.l_stats->log_mean_pb_error;
   uint8_t stop_index;
@@ -255,18 +262,15 @@ void LevelGenotyperModel::add_likelihood(allele_vector const& alleles,
   }
 
   assert(alleles.size() == stop_index);
-  assert(allele_indices.size() == stop_index);
   double compatible_coverage, gap_penalty;
   for (uint8_t i = 0; i < stop_index; i++) {
     auto const& allele = alleles.at(i);
     compatible_coverage = allele.get_average_cov();
     gap_penalty = fraction_noncredible_positions(allele);
-    log_likelihood +=
-        data.l_stats->pmf_full_depth->operator()(params{compatible_coverage});
+    log_likelihood += data.l_stats->log_pmf_full_depth(compatible_coverage);
     log_likelihood += gap_penalty * data.l_stats->log_zero;
   }
-
-  likelihoods.insert({log_likelihood, allele_indices});
+  return log_likelihood;
 }
 
 void LevelGenotyperModel::compute_haploid_log_likelihoods(
@@ -315,6 +319,12 @@ void LevelGenotyperModel::compute_heterozygous_log_likelihoods(
   }
 
   if (selected_indices.size() < 2) return;
+  if (selected_indices.size() > data.max_exhaustive_het_alleles &&
+      data.l_stats->log_mean_pb_error <= 0) {
+    compute_bounded_heterozygous_log_likelihoods(
+        input_alleles, selected_indices, haplogroup_multiplicities);
+    return;
+  }
 
   auto all_diploid_combos = get_permutations(selected_indices, 2);
 
@@ -332,6 +342,99 @@ void LevelGenotyperModel::compute_heterozygous_log_likelihoods(
   }
 }
 
+bool is_callable(allele_vector const& alleles, GtypedIndices const& gtype) {
+  for (auto const& gt : gtype)
+    if (!alleles.at(gt).callable) return false;
+  return true;
+}
+
+void LevelGenotyperModel::compute_bounded_heterozygous_log_likelihoods(
+    allele_vector const& input_alleles, GtypedIndices const& candidates,
+    multiplicities const& haplogroup_multiplicities) {
+  auto const log_error = data.l_stats->log_mean_pb_error;
+  // A pair's likelihood is at most `base_bound` plus each allele's weight
+  double const base_bound = total_coverage * log_error;
+  struct WeightedAllele {
+    std::size_t rank;  // Position in `candidates`
+    double weight;
+  };
+  std::vector<WeightedAllele> weighted;
+  weighted.reserve(candidates.size());
+  for (std::size_t rank = 0; rank < candidates.size(); ++rank) {
+    auto const& allele = input_alleles.at(candidates[rank]);
+    double weight =
+        data.l_stats->log_pmf_full_depth(allele.get_average_cov()) +
+        fraction_noncredible_positions(allele) * data.l_stats->log_zero -
+        haploid_allele_coverages.at(allele.haplogroup) * log_error;
+    weighted.push_back({rank, weight});
+  }
+  std::stable_sort(weighted.begin(), weighted.end(),
+                   [](WeightedAllele const& first,
+                      WeightedAllele const& second) {
+                     return first.weight > second.weight;
+                   });
+
+  // Best and second best likelihoods of callable genotypes so far
+  double best{-std::numeric_limits<double>::infinity()}, second_best{best};
+  auto record_callable = [&](double likelihood) {
+    if (likelihood > best) {
+      second_best = best;
+      best = likelihood;
+    } else if (likelihood > second_best)
+      second_best = likelihood;
+  };
+  for (auto const& entry : likelihoods)
+    if (is_callable(input_alleles, entry.second)) record_callable(entry.first);
+  // The bound gets some slack for rounding, as it sums terms in another order
+  auto hopeless = [&](double bound) {
+    return bound + 1e-9 * (1 + std::abs(bound)) < second_best;
+  };
+
+  struct ScoredPair {
+    std::size_t rank;  // Position in the exhaustive search's order
+    GtypedIndices gtype;
+    double likelihood;
+  };
+  std::vector<ScoredPair> kept;
+  auto const num_candidates = weighted.size();
+  for (std::size_t i = 0; i + 1 < num_candidates; ++i) {
+    if (hopeless(base_bound + weighted[i].weight + weighted[i + 1].weight))
+      break;
+    for (std::size_t j = i + 1; j < num_candidates; ++j) {
+      if (hopeless(base_bound + weighted[i].weight + weighted[j].weight))
+        break;
+      auto first_rank = weighted[i].rank, second_rank = weighted[j].rank;
+      if (first_rank > second_rank) std::swap(first_rank, second_rank);
+      GtypedIndices gtype{candidates.at(first_rank),
+                          candidates.at(second_rank)};
+
+      auto const& allele_1 = input_alleles.at(gtype.at(0));
+      auto const& allele_2 = input_alleles.at(gtype.at(1));
+      auto coverages = compute_diploid_coverage(
+          data.gp_counts, AlleleIds{allele_1.haplogroup, allele_2.haplogroup},
+          haplogroup_multiplicities);
+      auto incompatible_coverage =
+          total_coverage - coverages.first - coverages.second;
+      auto likelihood = compute_likelihood(allele_vector{allele_1, allele_2},
+                                           incompatible_coverage);
+      if (likelihood < second_best) continue;
+      if (is_callable(input_alleles, gtype)) record_callable(likelihood);
+      kept.push_back(
+          {first_rank * num_candidates + second_rank, gtype, likelihood});
+    }
+  }
+
+  // Equal likelihoods are ordered by insertion, so insert in the order of
+  // the exhaustive search
+  std::sort(kept.begin(), kept.end(),
+            [](ScoredPair const& first, ScoredPair const& second) {
+              return first.rank < second.rank;
+            });
+  for (auto const& pair : kept)
+    if (pair.likelihood >= second_best)
+      likelihoods.insert({pair.likelihood, pair.gtype});
+}
+
 void LevelGenotyperModel::add_next_best_alleles(
     allele_vector const& input_alleles, GtypedIndices const& chosen_gt,
     GtypedIndices const& next_best_gt) {
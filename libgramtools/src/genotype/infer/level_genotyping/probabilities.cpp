@@ -6,13 +6,15 @@
 
 namespace gram::genotype::infer::probabilities {
 double AbstractPmf::operator()(params const& query) {
-  if (probs.find(query) != probs.end())
-    return probs.at(query);
-  else {
-    auto prob = compute_prob(query);
-    probs.insert(std::pair<params, double>(query, prob));
-    return prob;
+  {
+    std::shared_lock<std::shared_mutex> lock(probs_mutex);
+    auto found = probs.find(query);
+    if (found != probs.end()) return found->second;
   }
+  auto prob = compute_prob(query);
+  std::unique_lock<std::shared_mutex> lock(probs_mutex);
+  probs.insert(std::pair<params, double>(query, prob));
+  return prob;
 }
 
 double PoissonLogPmf::compute_prob(params const& query) const {
@@ -38,6 +40,30 @@ double NegBinomLogPmf::compute_prob(params const& query) const {
           cov * log(1 - p));
 }
 
+LogPmfTable::LogPmfTable(pmf_ptr pmf, double max_cov, std::size_t resolution)
+    : pmf(pmf), resolution(resolution) {
+  if (!std::isfinite(max_cov) || max_cov < 0) max_cov = 0;
+  auto const num_values =
+      static_cast<std::size_t>(std::ceil(max_cov * resolution)) + 1;
+  values.reserve(num_values);
+  for (std::size_t i = 0; i < num_values; ++i)
+    values.push_back(pmf->evaluate(params{double(i) / resolution}));
+}
+
+double LogPmfTable::operator()(double cov) const {
+  double const position = cov * resolution;
+  if (position >= 0 && position + 1 < values.size()) {
+    auto const lower = static_cast<std::size_t>(position);
+    double const fraction = position - lower;
+    auto const lower_value = values[lower];
+    if (fraction == 0) return lower_value;
+    auto const upper_value = values[lower + 1];
+    if (std::isfinite(lower_value) && std::isfinite(upper_value))
+      return lower_value + fraction * (upper_value - lower_value);
+  }
+  return (*pmf)(params{cov});
+}
+
 std::ostream& operator<<(std::ostream& os,
                          const likelihood_related_stats& l_stats) {
   char buf[1024];
@@ -1,9 +1,19 @@
 #include "genotype/infer/level_genotyping/runner.hpp"
 
+#include <atomic>
 #include <cmath>
+#include <exception>
+#include <filesystem>
+#include <optional>
 #include <random>
+#include <sstream>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include "GCP/GCP.h"
+#include "common/random.hpp"
 #include "genotype/infer/allele_extracter.hpp"
 #include "genotype/infer/level_genotyping/model.hpp"
 #include "genotype/infer/output_specs/fields.hpp"
@@ -12,6 +22,7 @@
 #include "prg/make_data_structures.hpp"
 
 using namespace gram::genotype::output_spec;
+namespace fs = std::filesystem;
 
 void add_percentiles(gt_sites const& input_sites,
                      std::vector<double> const& confidences) {
@@ -27,7 +38,8 @@ void add_percentiles(gt_sites const& input_sites,
 LevelGenotyper::LevelGenotyper(coverage_Graph const& cov_graph,
                                SitesGroupedAlleleCounts const& gped_covs,
                                ReadStats const& read_stats, Ploidy const ploidy,
-                               bool get_gcp, std::string debug_fpath)
+                               bool get_gcp, std::string debug_fpath,
+                               std::string gcp_cache_dirpath)
     : ploidy(ploidy) {
   this->cov_graph = &cov_graph;
   this->gped_covs = &gped_covs;
@@ -50,52 +62,108 @@ LevelGenotyper::LevelGenotyper(coverage_Graph const& cov_graph,
     debug_file << l_stats;
   }
 
-  // Genotype each bubble in the PRG, in most nested to less nested order.
-  for (auto const& bubble_pair : cov_graph.bubble_map) {
-    auto site_ID = bubble_pair.first->get_site_ID();
-    auto site_index = siteID_to_index(site_ID);
-
-    auto extracter = AlleleExtracter(bubble_pair.first, bubble_pair.second,
-                                     genotyped_records);
-    auto extracted_alleles = extracter.get_alleles();
-    auto& gped_covs_for_site = gped_covs.at(site_index);
-
-    ModelData data(extracted_alleles, gped_covs_for_site, ploidy, &l_stats,
-                   debug);
-    auto genotyped = LevelGenotyperModel(data);
-    auto genotyped_site = genotyped.get_site();
-    genotyped_site->set_pos(bubble_pair.first->get_pos());
-
-    if (debug_file.is_open()) {
-      debug_file << "site index: \t" << site_index;
-      if (genotyped_site->is_null())
-        debug_file << "\tnull gt \n";
-      else {
-        debug_file << genotyped_site->get_debug_info();
-        debug_file << "\n";
+  auto const num_sites = cov_graph.bubble_map.size();
+  std::vector<covG_ptr_map::value_type const*> bubbles(num_sites);
+  for (auto const& bubble_pair : cov_graph.bubble_map)
+    bubbles.at(siteID_to_index(bubble_pair.first->get_site_ID())) =
+        &bubble_pair;
+
+  // A site can only be genotyped once all sites nested directly in it have
+  // been: the last of them to get processed hands over to it. Sites not
+  // nested in each other are processed independently, in parallel.
+  auto const no_parent = num_sites;
+  std::vector<std::size_t> parents(num_sites, no_parent);
+  std::vector<std::atomic<std::size_t>> pending_children(num_sites);
+  for (auto const& entry : cov_graph.par_map) {
+    auto const parent_index = siteID_to_index(entry.second.first);
+    parents.at(siteID_to_index(entry.first)) = parent_index;
+    ++pending_children.at(parent_index);
+  }
+  std::vector<std::size_t> ready_sites;
+  for (std::size_t i = 0; i < num_sites; ++i)
+    if (pending_children[i] == 0) ready_sites.push_back(i);
+
+  std::vector<std::string> debug_entries(debug ? num_sites : 0);
+  // Exceptions cannot leave an OpenMP region, so are rethrown after it
+  std::vector<std::exception_ptr> errors(ready_sites.size());
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t i = 0; i < ready_sites.size(); ++i) {
+    try {
+      auto site_index = ready_sites[i];
+      while (site_index != no_parent) {
+        auto const& bubble = *bubbles[site_index];
+        auto debug_entry = genotype_site(bubble.first, bubble.second, debug);
+        if (debug) debug_entries[site_index] = std::move(debug_entry);
+
+        auto const parent_index = parents[site_index];
+        if (parent_index == no_parent || --pending_children[parent_index] > 0)
+          break;
+        site_index = parent_index;
       }
+    } catch (...) {
+      errors[i] = std::current_exception();
     }
-
-    // Line below is so that when allele extraction occurs and jumps through a
-    // previously genotyped site, it knows where in the graph to resume from.
-    genotyped_site->set_site_end_node(bubble_pair.second);
-
-    genotyped_records.at(site_index) = genotyped_site;
-
-    auto downcasted =
-        std::dynamic_pointer_cast<LevelGenotypedSite>(genotyped_site);
-    run_invalidation_process(downcasted, site_ID);
-    if (genotyped_site->has_filter("AMBIG"))
-      downpropagate_filter("AMBIG", site_ID);
-    else
-      uppropagate_filter("AMBIG", site_ID);
   }
+  for (auto const& error : errors)
+    if (error) std::rethrow_exception(error);
+
+  // Debug output keeps the most nested to less nested order of the sites
+  if (debug_file.is_open()) {
+    for (auto const& bubble_pair : cov_graph.bubble_map)
+      debug_file << debug_entries.at(
+          siteID_to_index(bubble_pair.first->get_site_ID()));
+  }
+
   if (get_gcp) {
-    auto confidences = get_gtconf_distrib(genotyped_records, l_stats, ploidy);
+    auto confidences = get_gtconf_distrib(genotyped_records, l_stats, ploidy,
+                                          gcp_cache_dirpath);
     add_percentiles(genotyped_records, confidences);
   }
 }
 
+std::string LevelGenotyper::genotype_site(covG_ptr const& site_start,
+                                          covG_ptr const& site_end,
+                                          bool const debug) {
+  auto site_ID = site_start->get_site_ID();
+  auto site_index = siteID_to_index(site_ID);
+
+  auto extracter = AlleleExtracter(site_start, site_end, genotyped_records);
+  auto extracted_alleles = extracter.get_alleles();
+  auto& gped_covs_for_site = gped_covs->at(site_index);
+
+  ModelData data(extracted_alleles, gped_covs_for_site, ploidy, &l_stats,
+                 debug);
+  auto genotyped = LevelGenotyperModel(data);
+  auto genotyped_site = genotyped.get_site();
+  genotyped_site->set_pos(site_start->get_pos());
+
+  std::ostringstream debug_entry;
+  if (debug) {
+    debug_entry << "site index: \t" << site_index;
+    if (genotyped_site->is_null())
+      debug_entry << "\tnull gt \n";
+    else {
+      debug_entry << genotyped_site->get_debug_info();
+      debug_entry << "\n";
+    }
+  }
+
+  // Line below is so that when allele extraction occurs and jumps through a
+  // previously genotyped site, it knows where in the graph to resume from.
+  genotyped_site->set_site_end_node(site_end);
+
+  genotyped_records.at(site_index) = genotyped_site;
+
+  auto downcasted =
+      std::dynamic_pointer_cast<LevelGenotypedSite>(genotyped_site);
+  run_invalidation_process(downcasted, site_ID);
+  if (genotyped_site->has_filter("AMBIG"))
+    downpropagate_filter("AMBIG", site_ID);
+  else
+    uppropagate_filter("AMBIG", site_ID);
+  return debug_entry.str();
+}
+
 header_vec LevelGenotyper::get_model_specific_headers() {
   auto site_model_entries = LevelGenotypedSite::site_model_specific_entries();
   header_vec result{
@@ -196,6 +264,14 @@ void LevelGenotyper::invalidate_if_needed(Marker const& parent_site_ID,
   }
 }
 
+/**
+ * Coverages up to well above the mean get tabulated: likelihoods are mostly
+ * computed from coverages within a few standard deviations of the mean.
+ */
+double max_tabulated_cov(double const mean_cov, double const var_cov) {
+  return mean_cov + 10 * sqrt(std::max(mean_cov, var_cov)) + 64;
+}
+
 /**
  * Flexible use of Poisson or Negative Binomial prob. mass function (pmf)
  * Neg binom:
@@ -243,7 +319,8 @@ likelihood_related_stats LevelGenotyper::make_l_stats(
       prob_no_zero_half_depth,
       find_minimum_non_error_cov(mean_pb_error, pmf),
       pmf,
-      pmf_half_depth};
+      pmf_half_depth,
+      LogPmfTable(pmf, max_tabulated_cov(mean_cov, var_cov))};
 }
 
 CovCount LevelGenotyper::find_minimum_non_error_cov(double mean_pb_error,
@@ -265,8 +342,9 @@ class ModelDataProducer : public GCP::Model<ModelData> {
   Ploidy ploidy;
 
  public:
-  ModelDataProducer(likelihood_related_stats const* l_stats, Ploidy ploidy)
-      : l_stats(l_stats), ploidy(ploidy){};
+  ModelDataProducer(likelihood_related_stats const* l_stats, Ploidy ploidy,
+                    SeedSize seed)
+      : GCP::Model<ModelData>(seed), l_stats(l_stats), ploidy(ploidy){};
 
   ModelData produce_data() override {
     CovCount correct_cov;
@@ -296,21 +374,127 @@ class ModelDataProducer : public GCP::Model<ModelData> {
   }
 };
 
+std::vector<double> LevelGenotyper::simulate_gtconfs(
+    likelihood_related_stats const& input_lstats, Ploidy const& input_ploidy,
+    std::size_t num_simulations, SeedSize seed) {
+  // Each block of simulations gets its own data producer, seeded from the
+  // block's index, so results do not depend on the number of threads
+  constexpr std::size_t block_size{100};
+  std::vector<double> confidences(num_simulations);
+  auto const num_blocks = (num_simulations + block_size - 1) / block_size;
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t block = 0; block < num_blocks; ++block) {
+    ModelDataProducer data_producer(&input_lstats, input_ploidy,
+                                    derive_seed(seed, block));
+    auto const last = std::min((block + 1) * block_size, num_simulations);
+    for (auto i = block * block_size; i < last; ++i) {
+      auto model_data = data_producer.produce_data();
+      LevelGenotyperModel genotyped(model_data);
+      confidences[i] = genotyped.get_genotype_confidence();
+    }
+  }
+  return confidences;
+}
+
+namespace {
+/** A parameter rounded to the cache grid, and its index on the grid */
+struct GridValue {
+  std::string key;
+  double value;
+};
+
+/**
+ * Rounds positive values to the nearest power of `1 + gcp_cache_grid_step`:
+ * grid points are that relative step apart.
+ */
+GridValue round_to_gcp_grid(double const value) {
+  if (!(value > 0)) return GridValue{"0", 0};
+  auto const log_step = std::log1p(gcp_cache_grid_step);
+  auto const index = std::llround(std::log(value) / log_step);
+  return GridValue{std::to_string(index), std::exp(index * log_step)};
+}
+}  // namespace
+
+/**
+ * Cached simulations are shared between samples with similar coverage models.
+ * The mean and variance of coverage depth and the error rate, from which
+ * `make_l_stats` derives the model, get rounded to a grid. The file name holds
+ * their grid indices and the ploidy. Simulations use the rounded model, so a
+ * cached and a freshly simulated run give the same confidences.
+ */
+std::pair<fs::path, likelihood_related_stats> gcp_cache_entry(
+    std::string const& cache_dirpath,
+    likelihood_related_stats const& input_lstats, Ploidy const& input_ploidy) {
+  auto const& data_params = input_lstats.data_params;
+  auto const mean_cov = round_to_gcp_grid(data_params.mean_cov);
+  auto const mean_pb_error = round_to_gcp_grid(data_params.mean_pb_error);
+  // The variance is only used if the model is negative binomial
+  GridValue var_cov{"poisson", mean_cov.value};
+  if (data_params.num_successes > 0)
+    var_cov = round_to_gcp_grid(data_params.mean_cov +
+                                std::pow(data_params.mean_cov, 2) /
+                                    data_params.num_successes);
+
+  std::ostringstream fname;
+  fname << "gcp_" << mean_cov.key << "_" << var_cov.key << "_"
+        << mean_pb_error.key << "_"
+        << (input_ploidy == Ploidy::Haploid ? "haploid" : "diploid") << ".bin";
+  return {fs::path(cache_dirpath) / fname.str(),
+          LevelGenotyper::make_l_stats(mean_cov.value, var_cov.value,
+                                       mean_pb_error.value)};
+}
+
+std::optional<std::vector<double>> read_gcp_cache(fs::path const& fpath) {
+  std::ifstream ifs{fpath, std::ios::binary};
+  if (!ifs) return std::nullopt;
+  std::vector<double> confidences;
+  try {
+    boost::archive::binary_iarchive ia{ifs};
+    ia >> confidences;
+  } catch (std::exception const&) {
+    return std::nullopt;
+  }
+  if (confidences.size() != CONF_DISTRIB_SIZE) return std::nullopt;
+  return confidences;
+}
+
+/**
+ * Writes to a temporary file first, so that concurrent runs sharing the cache
+ * never read a partially written file.
+ */
+void write_gcp_cache(fs::path const& fpath,
+                     std::vector<double> const& confidences) {
+  try {
+    fs::create_directories(fpath.parent_path());
+    auto tmp_fpath = fpath;
+    tmp_fpath += ".tmp" + std::to_string(std::random_device{}());
+    {
+      std::ofstream ofs{tmp_fpath, std::ios::binary};
+      boost::archive::binary_oarchive oa{ofs};
+      oa << confidences;
+    }
+    fs::rename(tmp_fpath, fpath);
+  } catch (std::exception const& e) {
+    std::cout << "Warning: could not cache simulated genotype confidences to "
+              << fpath << ": " << e.what() << std::endl;
+  }
+}
+
 /**
  * Draws empirical confidences from the genotyped sites
  * and complements them with simulations if there are not enough.
+ * Draws are seeded with `gcp_seed`, so results only depend on the inputs.
  */
 std::vector<double> LevelGenotyper::get_gtconf_distrib(
     gt_sites const& input_sites, likelihood_related_stats const& input_lstats,
-    Ploidy const& input_ploidy) {
+    Ploidy const& input_ploidy, std::string const& cache_dirpath) {
   constexpr uint16_t distrib_size{CONF_DISTRIB_SIZE};
   std::vector<double> confidences(distrib_size);
   auto insertion_point = confidences.begin();
 
   // Case: draw all needed confidences at random from sites
   if (input_sites.size() > distrib_size) {
-    std::random_device rd;
-    std::mt19937 generator(rd());
+    std::mt19937 generator(gcp_seed);
     std::uniform_int_distribution<> distrib(0, input_sites.size() - 1);
     while (insertion_point != confidences.end()) {
       auto selected_entry = distrib(generator);
@@ -324,13 +508,25 @@ std::vector<double> LevelGenotyper::get_gtconf_distrib(
     for (auto const& site : input_sites)
       *insertion_point++ =
           std::dynamic_pointer_cast<LevelGenotypedSite>(site)->get_gt_conf();
-    auto num_simulations = std::distance(insertion_point, confidences.end());
-    // Perform simulations
-    GCP::Model<ModelData>* data_producer =
-        new ModelDataProducer(&input_lstats, input_ploidy);
-    GCP::Simulator<ModelData, LevelGenotyperModel> simulator(data_producer);
-    auto simu = simulator.simulate(num_simulations);
-    std::copy(simu.begin(), simu.end(), insertion_point);
+    std::size_t num_simulations =
+        std::distance(insertion_point, confidences.end());
+    std::vector<double> simu;
+    if (cache_dirpath.empty())
+      simu = simulate_gtconfs(input_lstats, input_ploidy, num_simulations);
+    else {
+      // A full set of simulations gets cached; the first `num_simulations` of
+      // them are the same as simulating only those.
+      auto const [cache_fpath, grid_lstats] =
+          gcp_cache_entry(cache_dirpath, input_lstats, input_ploidy);
+      auto cached = read_gcp_cache(cache_fpath);
+      if (cached)
+        simu = std::move(cached.value());
+      else {
+        simu = simulate_gtconfs(grid_lstats, input_ploidy, distrib_size);
+        write_gcp_cache(cache_fpath, simu);
+      }
+    }
+    std::copy(simu.begin(), simu.begin() + num_simulations, insertion_point);
   }
   std::sort(confidences.begin(), confidences.end());
   return confidences;
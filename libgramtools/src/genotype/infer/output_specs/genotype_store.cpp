@@ -0,0 +1,556 @@
+#include "genotype/infer/output_specs/genotype_store.hpp"
+
+#include <fcntl.h>
+#include <htslib/vcf.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "common/parallel.hpp"
+#include "genotype/infer/level_genotyping/site.hpp"
+
+using namespace gram;
+using namespace gram::json;
+using namespace gram::genotype::infer;
+namespace fs = std::filesystem;
+
+namespace {
+/**
+ * Exclusive advisory lock on a file, held for the lifetime of the object.
+ * Blocks until other holders release it.
+ */
+class FileLock {
+ public:
+  explicit FileLock(std::string const& fpath)
+      : fd(::open(fpath.c_str(), O_RDWR | O_CREAT, 0644)) {
+    if (fd < 0) throw GenotypeStoreException("Could not open lock " + fpath);
+    if (::flock(fd, LOCK_EX) != 0) {
+      ::close(fd);
+      throw GenotypeStoreException("Could not lock " + fpath);
+    }
+  }
+  ~FileLock() {
+    ::flock(fd, LOCK_UN);
+    ::close(fd);
+  }
+  FileLock(FileLock const&) = delete;
+  FileLock& operator=(FileLock const&) = delete;
+
+ private:
+  int fd;
+};
+
+/** Site fields with a dedicated column; all others are model-specific */
+const strings common_site_fields{"POS", "SEG", "ALS", "GT",
+                                 "HAPG", "COV", "DP", "FT"};
+
+strings get_model_fields(JSON const& site) {
+  strings result;
+  for (auto const& entry : site.items()) {
+    if (std::find(common_site_fields.begin(), common_site_fields.end(),
+                  entry.key()) == common_site_fields.end())
+      result.push_back(entry.key());
+  }
+  return result;
+}
+
+double to_number(JSON const& value, std::string const& field) {
+  if (value.is_null()) return std::numeric_limits<double>::quiet_NaN();
+  if (!value.is_number())
+    throw GenotypeStoreException("Site field " + field +
+                                 " does not hold numbers");
+  return value.get<double>();
+}
+
+JSON from_number(double value) {
+  if (std::isnan(value)) return nullptr;
+  return value;
+}
+
+void add_site_genotypes(GenotypeStoreChunk& chunk, JSON const& site,
+                        std::size_t num_samples, strings const& model_fields) {
+  auto const& alleles = site.at("ALS");
+  if (alleles.empty()) throw JSONConsistencyException("Site without alleles");
+  strings alt_alleles;
+  for (std::size_t i = 1; i < alleles.size(); ++i)
+    alt_alleles.push_back(alleles.at(i));
+  chunk.alt_alleles.push_back(alt_alleles);
+
+  for (auto const& entry : trivially_merged_entries) {
+    if (site.at(entry).size() != num_samples)
+      throw JSONConsistencyException(
+          "JSON does not have number of " + entry +
+          " arrays consistent with its number of Samples");
+  }
+  for (std::size_t s = 0; s < num_samples; ++s) {
+    auto const& gts = site.at("GT").at(s);
+    if (!gts.empty() && gts.at(0) == nullptr)
+      chunk.genotypes.push_back(GtypedIndices{-1});
+    else
+      chunk.genotypes.push_back(gts.get<GtypedIndices>());
+    chunk.haplogroups.push_back(site.at("HAPG").at(s).get<AlleleIds>());
+    chunk.coverages.push_back(site.at("COV").at(s).get<allele_coverages>());
+    chunk.depths.push_back(site.at("DP").at(s).get<uint64_t>());
+    chunk.filters.push_back(site.at("FT").at(s).get<strings>());
+  }
+
+  chunk.model_fields.resize(model_fields.size());
+  for (std::size_t i = 0; i < model_fields.size(); ++i) {
+    auto const& field = model_fields[i];
+    auto const& values = site.at(field);
+    if (values.size() != num_samples)
+      throw JSONConsistencyException(
+          "JSON does not have number of " + field +
+          " entries consistent with its number of Samples");
+    auto& column = chunk.model_fields[i];
+    for (auto const& value : values) {
+      std::vector<double> numbers;
+      if (value.is_array())
+        for (auto const& element : value)
+          numbers.push_back(to_number(element, field));
+      else
+        numbers.push_back(to_number(value, field));
+      column.values.push_back(numbers);
+      column.is_array.push_back(value.is_array());
+    }
+  }
+}
+}  // namespace
+
+GenotypeStore::GenotypeStore(std::string dirpath, std::size_t sites_per_chunk)
+    : dirpath(std::move(dirpath)),
+      sites_per_chunk(std::max<std::size_t>(1, sites_per_chunk)) {
+  if (fs::exists(fs::path(this->dirpath) / "meta.bin")) read_meta();
+}
+
+std::string GenotypeStore::batch_dirpath(std::size_t batch) const {
+  return fs::path(dirpath) / ("batch_" + std::to_string(batch));
+}
+
+std::string GenotypeStore::chunk_fpath(std::size_t batch,
+                                       std::size_t chunk) const {
+  return fs::path(batch_dirpath(batch)) /
+         ("chunk_" + std::to_string(chunk) + ".bin");
+}
+
+void GenotypeStore::read_meta() {
+  std::ifstream meta_in(fs::path(dirpath) / "meta.bin", std::ios::binary);
+  std::ifstream sites_in(fs::path(dirpath) / "sites.bin", std::ios::binary);
+  if (!meta_in.good() || !sites_in.good())
+    throw GenotypeStoreException("Could not open genotype store " + dirpath);
+  try {
+    boost::archive::binary_iarchive meta{meta_in};
+    uint32_t version;
+    meta >> version;
+    if (version != GENOTYPE_STORE_VERSION)
+      throw GenotypeStoreException("Unsupported genotype store version in " +
+                                   dirpath);
+    std::string header_dump;
+    meta >> header_dump >> sites_per_chunk >> batch_sizes >>
+        batch_model_fields;
+    header = JSON::parse(header_dump);
+
+    boost::archive::binary_iarchive sites{sites_in};
+    sites >> positions >> segment_IDs >> segments >> refs;
+  } catch (boost::archive::archive_exception const& e) {
+    throw GenotypeStoreException("Corrupted genotype store " + dirpath + ": " +
+                                 e.what());
+  }
+}
+
+/**
+ * Written to a temporary file first and renamed, so that a failed append
+ * leaves the store as it was.
+ */
+void GenotypeStore::write_meta() const {
+  auto const fpath = fs::path(dirpath) / "meta.bin";
+  auto tmp_fpath = fpath;
+  tmp_fpath += ".tmp";
+  {
+    std::ofstream ofs{tmp_fpath, std::ios::binary};
+    boost::archive::binary_oarchive oa{ofs};
+    oa << GENOTYPE_STORE_VERSION << header.dump() << sites_per_chunk
+       << batch_sizes << batch_model_fields;
+  }
+  fs::rename(tmp_fpath, fpath);
+}
+
+void GenotypeStore::write_sites() const {
+  std::ofstream ofs{fs::path(dirpath) / "sites.bin", std::ios::binary};
+  boost::archive::binary_oarchive oa{ofs};
+  oa << positions << segment_IDs << segments << refs;
+}
+
+GenotypeStoreChunk GenotypeStore::read_chunk(std::size_t batch,
+                                             std::size_t chunk) const {
+  auto const fpath = chunk_fpath(batch, chunk);
+  std::ifstream ifs{fpath, std::ios::binary};
+  if (!ifs.good()) throw GenotypeStoreException("Could not open " + fpath);
+  GenotypeStoreChunk result;
+  try {
+    boost::archive::binary_iarchive ia{ifs};
+    ia >> result;
+  } catch (boost::archive::archive_exception const& e) {
+    throw GenotypeStoreException("Corrupted chunk " + fpath + ": " +
+                                 e.what());
+  }
+  return result;
+}
+
+void GenotypeStore::write_chunk(GenotypeStoreChunk const& chunk,
+                                std::size_t batch,
+                                std::size_t chunk_index) const {
+  auto const fpath = chunk_fpath(batch, chunk_index);
+  std::ofstream ofs{fpath, std::ios::binary};
+  if (!ofs.good()) throw GenotypeStoreException("Could not open " + fpath);
+  boost::archive::binary_oarchive oa{ofs};
+  oa << chunk;
+}
+
+void GenotypeStore::add_site_position(JSON const& site, std::size_t site_index,
+                                      bool new_sites) {
+  uint64_t const pos = site.at("POS");
+  std::string const segment = site.at("SEG");
+  std::string const ref = site.at("ALS").at(0);
+  if (new_sites) {
+    if (segment_IDs.empty() || segment_IDs.back() != segment)
+      segment_IDs.push_back(segment);
+    positions.push_back(pos);
+    segments.push_back(segment_IDs.size() - 1);
+    refs.push_back(ref);
+    return;
+  }
+
+  if (site_index >= num_sites())
+    throw JSONCombineException("JSONs do not have the same number of sites");
+  if (positions[site_index] != pos ||
+      segment_IDs[segments[site_index]] != segment)
+    throw JSONCombineException("Sites do not have same POS or SEG");
+  if (refs[site_index] != ref)
+    throw JSONCombineException("Sites do not have same 'reference' allele: " +
+                               refs[site_index] + " vs " + ref);
+}
+
+void GenotypeStore::append(JsonSiteReader& reader, bool force) {
+  // Other processes may have appended since this store was opened: the
+  // metadata is re-read under the lock, which is held until it is rewritten
+  fs::create_directories(dirpath);
+  FileLock lock{fs::path(dirpath) / "lock"};
+  if (fs::exists(fs::path(dirpath) / "meta.bin")) read_meta();
+
+  bool const new_store = batch_sizes.empty();
+  auto const& input_header = reader.get_header();
+  JSON new_header;
+  if (new_store)
+    new_header = input_header;
+  else {
+    Json_Prg combined(header);
+    combined.check_combinable(input_header);
+    combined.add_sample_names(input_header.at("Samples"), force);
+    new_header = combined.get_prg();
+  }
+  std::size_t const num_samples = input_header.at("Samples").size();
+  std::size_t const batch = batch_sizes.size();
+
+  // Leftovers of a failed append get overwritten
+  fs::remove_all(batch_dirpath(batch));
+  fs::create_directories(batch_dirpath(batch));
+  try {
+    strings model_fields;
+    GenotypeStoreChunk chunk;
+    std::size_t num_read{0};
+    JSON site;
+    while (reader.next_site(site)) {
+      if (num_read == 0) model_fields = get_model_fields(site);
+      add_site_position(site, num_read, new_store);
+      add_site_genotypes(chunk, site, num_samples, model_fields);
+      if (++num_read % sites_per_chunk == 0) {
+        write_chunk(chunk, batch, num_read / sites_per_chunk - 1);
+        chunk = GenotypeStoreChunk();
+      }
+    }
+    if (num_read % sites_per_chunk != 0)
+      write_chunk(chunk, batch, num_read / sites_per_chunk);
+    if (num_read != num_sites())
+      throw JSONCombineException("JSONs do not have the same number of sites");
+
+    batch_sizes.push_back(num_samples);
+    batch_model_fields.push_back(model_fields);
+    std::swap(header, new_header);
+    if (new_store) write_sites();
+    write_meta();
+  } catch (...) {
+    if (batch_sizes.size() > batch) {
+      batch_sizes.pop_back();
+      batch_model_fields.pop_back();
+      std::swap(header, new_header);
+    }
+    if (new_store) {
+      positions.clear();
+      segment_IDs.clear();
+      segments.clear();
+      refs.clear();
+    }
+    fs::remove_all(batch_dirpath(batch));
+    throw;
+  }
+}
+
+JSON GenotypeStore::make_site(GenotypeStoreChunk const& chunk,
+                              std::size_t chunk_site, std::size_t site_index,
+                              std::size_t batch) const {
+  auto const num_samples = batch_sizes[batch];
+  JSON site;
+  site["POS"] = positions[site_index];
+  site["SEG"] = segment_IDs[segments[site_index]];
+  auto alleles = chunk.alt_alleles.at(chunk_site);
+  alleles.insert(alleles.begin(), refs[site_index]);
+  site["ALS"] = alleles;
+
+  for (auto const& entry : trivially_merged_entries)
+    site[entry] = JSON::array();
+  for (std::size_t s = 0; s < num_samples; ++s) {
+    auto const i = chunk_site * num_samples + s;
+    auto const gts = chunk.genotypes.at(i);
+    if (gts == GtypedIndices{-1})
+      site["GT"].push_back(JSON::array({nullptr}));
+    else
+      site["GT"].push_back(gts);
+    site["HAPG"].push_back(chunk.haplogroups.at(i));
+    site["COV"].push_back(chunk.coverages.at(i));
+    site["DP"].push_back(chunk.depths.at(i));
+    site["FT"].push_back(chunk.filters.at(i));
+  }
+
+  auto const& model_fields = batch_model_fields[batch];
+  for (std::size_t f = 0; f < model_fields.size(); ++f) {
+    auto const& column = chunk.model_fields.at(f);
+    auto& values = site[model_fields[f]] = JSON::array();
+    for (std::size_t s = 0; s < num_samples; ++s) {
+      auto const i = chunk_site * num_samples + s;
+      auto const numbers = column.values.at(i);
+      if (column.is_array.at(i)) {
+        JSON array = JSON::array();
+        for (auto const number : numbers) array.push_back(from_number(number));
+        values.push_back(array);
+      } else
+        values.push_back(from_number(numbers.at(0)));
+    }
+  }
+  return site;
+}
+
+std::vector<JSON> GenotypeStore::get_sites(std::size_t first,
+                                           std::size_t last) const {
+  if (first > last || last > num_sites())
+    throw GenotypeStoreException("Invalid site range: " +
+                                 std::to_string(first) + " to " +
+                                 std::to_string(last));
+  if (first == last) return {};
+
+  auto const first_chunk = first / sites_per_chunk;
+  auto const range_chunks = (last - 1) / sites_per_chunk - first_chunk + 1;
+  auto const batches = num_batches();
+  // Indexed by chunk in the range, then by batch
+  std::vector<std::vector<GenotypeStoreChunk>> chunks(
+      range_chunks, std::vector<GenotypeStoreChunk>(batches));
+  parallel_for(range_chunks * batches, [&](std::size_t i) {
+    chunks[i / batches][i % batches] =
+        read_chunk(i % batches, first_chunk + i / batches);
+  });
+
+  std::string const gtyping_model = header.at("Model");
+  std::vector<JSON> result(last - first);
+  parallel_for(result.size(), [&](std::size_t j) {
+    auto const site_index = first + j;
+    auto const& site_chunks =
+        chunks[site_index / sites_per_chunk - first_chunk];
+    std::vector<JSON> batch_sites;
+    for (std::size_t b = 0; b < batches; ++b)
+      batch_sites.push_back(make_site(
+          site_chunks[b], site_index % sites_per_chunk, site_index, b));
+    result[j] = combine_sites(std::move(batch_sites), gtyping_model);
+  });
+  return result;
+}
+
+void GenotypeStore::write_json(std::ostream& out) const {
+  if (num_batches() == 0)
+    throw GenotypeStoreException("Empty genotype store " + dirpath);
+
+  write_json_with_streamed_sites(out, header, [&](std::ostream& sites_out) {
+    sites_out << '[';
+    for (std::size_t start = 0; start < num_sites();
+         start += sites_per_chunk) {
+      auto const sites =
+          get_sites(start, std::min(start + sites_per_chunk, num_sites()));
+      std::vector<std::string> serialised(sites.size());
+      parallel_for(sites.size(),
+                   [&](std::size_t j) { serialised[j] = sites[j].dump(); });
+      for (std::size_t j = 0; j < serialised.size(); ++j) {
+        if (start + j > 0) sites_out << ',';
+        sites_out << serialised[j];
+      }
+    }
+    sites_out << ']';
+  });
+}
+
+namespace {
+using str_vec = std::vector<std::string>;
+
+/** Sets the FORMAT string field `ID` to one string per sample */
+void update_format_strings(bcf_hdr_t* hdr, bcf1_t* record, char const* ID,
+                           str_vec const& values) {
+  std::vector<char const*> c_values;
+  for (auto const& value : values) c_values.push_back(value.c_str());
+  bcf_update_format_string(hdr, record, ID, c_values.data(), c_values.size());
+}
+
+void populate_vcf_record(bcf_hdr_t* hdr, bcf1_t* record, JSON const& site,
+                         std::string const& gtyping_model) {
+  record->rid = bcf_hdr_name2id(hdr, site.at("SEG").get<std::string>().c_str());
+  record->pos = site.at("POS").get<uint64_t>() - 1;  // 1-based to 0-based
+
+  str_vec const alleles = site.at("ALS");
+  std::string als;
+  for (auto const& allele : alleles) {
+    if (!als.empty()) als += ",";
+    als += allele;
+  }
+  bcf_update_alleles_str(hdr, record, als.c_str());
+
+  auto const& gts = site.at("GT");
+  auto const num_samples = gts.size();
+  std::size_t ploidy{1};
+  for (auto const& sample_gts : gts) ploidy = std::max(ploidy, sample_gts.size());
+  std::vector<int32_t> genotypes(num_samples * ploidy, bcf_int32_vector_end);
+  for (std::size_t s = 0; s < num_samples; ++s) {
+    auto const& sample_gts = gts.at(s);
+    for (std::size_t j = 0; j < sample_gts.size(); ++j) {
+      auto& gt = genotypes[s * ploidy + j];
+      if (sample_gts.at(j).is_null())
+        gt = bcf_gt_missing;
+      else
+        gt = bcf_gt_unphased(sample_gts.at(j).get<int32_t>());
+    }
+  }
+  bcf_update_genotypes(hdr, record, genotypes.data(), genotypes.size());
+
+  str_vec depths;
+  for (auto const& depth : site.at("DP"))
+    depths.push_back(std::to_string(depth.get<uint64_t>()));
+  update_format_strings(hdr, record, "DP", depths);
+
+  // Null calls do not get their coverages rescaled when combining JSONs
+  std::vector<float> covs(num_samples * alleles.size());
+  for (std::size_t s = 0; s < num_samples; ++s) {
+    allele_coverages const sample_covs = site.at("COV").at(s);
+    for (std::size_t j = 0; j < alleles.size(); ++j) {
+      auto& cov = covs[s * alleles.size() + j];
+      if (sample_covs.size() == alleles.size())
+        cov = sample_covs[j];
+      else
+        bcf_float_set_missing(cov);
+    }
+  }
+  bcf_update_format_float(hdr, record, "COV", covs.data(), covs.size());
+
+  str_vec filters;
+  for (auto const& sample_filters : site.at("FT")) {
+    std::string joined;
+    for (auto const& filter : sample_filters) {
+      if (!joined.empty()) joined += ",";
+      joined += filter.get<std::string>();
+    }
+    filters.push_back(joined.empty() ? "PASS" : joined);
+  }
+  update_format_strings(hdr, record, "FT", filters);
+
+  if (gtyping_model != "LevelGenotyping") return;
+  for (auto const& entry : LevelGenotypedSite::site_model_specific_entries()) {
+    std::vector<float> values;
+    for (auto const& value : site.at(entry.ID)) {
+      values.emplace_back();
+      if (value.is_number())
+        values.back() = value.get<float>();
+      else
+        bcf_float_set_missing(values.back());
+    }
+    bcf_update_format_float(hdr, record, entry.ID.c_str(), values.data(),
+                            values.size());
+  }
+}
+}  // namespace
+
+void GenotypeStore::write_vcf(std::string const& fpath,
+                              std::size_t num_threads) const {
+  if (num_batches() == 0)
+    throw GenotypeStoreException("Empty genotype store " + dirpath);
+  auto fout = bcf_open(fpath.c_str(), "wz");
+  if (fout == nullptr) throw GenotypeStoreException("Could not open " + fpath);
+  if (num_threads > 1) hts_set_threads(fout, num_threads);
+
+  std::string const gtyping_model = header.at("Model");
+  bcf_hdr_t* hdr = bcf_hdr_init("w");
+  for (auto const& segment_ID : segment_IDs) {
+    auto contig =
+        vcf_meta_info_line("contig", segment_ID, std::size_t{0}).to_string();
+    bcf_hdr_append(hdr, contig.c_str());
+  }
+  auto source = vcf_meta_info_line("source", "gramtools").to_string();
+  bcf_hdr_append(hdr, source.c_str());
+  for (auto const& sample : header.at("Samples"))
+    bcf_hdr_add_sample(hdr, sample.at("Name").get<std::string>().c_str());
+  if (gtyping_model == "LevelGenotyping")
+    for (auto const& entry : LevelGenotypedSite::site_model_specific_entries())
+      bcf_hdr_append(hdr, entry.to_string().c_str());
+  for (auto const& entry : common_headers)
+    bcf_hdr_append(hdr, entry.to_string().c_str());
+  if (bcf_hdr_write(fout, hdr) != 0)
+    throw GenotypeStoreException("Failed to write vcf header");
+
+  // Only the sites not nested in any other go in the vcf
+  auto const& lvl1_sites = header.at("Lvl1_Sites");
+  std::vector<bool> is_lvl1(num_sites(), false);
+  if (lvl1_sites.size() == 1 && lvl1_sites.at(0) == "all")
+    is_lvl1.assign(num_sites(), true);
+  else
+    for (auto const& site_index : lvl1_sites)
+      is_lvl1.at(site_index.get<std::size_t>()) = true;
+
+  std::vector<bcf1_t*> records(std::min(sites_per_chunk, num_sites()));
+  for (auto& record : records) record = bcf_init();
+  for (std::size_t start = 0; start < num_sites(); start += sites_per_chunk) {
+    auto const sites =
+        get_sites(start, std::min(start + sites_per_chunk, num_sites()));
+    std::vector<std::size_t> chunk_lvl1;
+    for (std::size_t j = 0; j < sites.size(); ++j)
+      if (is_lvl1[start + j]) chunk_lvl1.push_back(j);
+
+    parallel_for(chunk_lvl1.size(), [&](std::size_t i) {
+      bcf_clear(records[i]);
+      populate_vcf_record(hdr, records[i], sites[chunk_lvl1[i]],
+                          gtyping_model);
+    });
+    for (std::size_t i = 0; i < chunk_lvl1.size(); ++i) {
+      if (bcf_write(fout, hdr, records[i]) != 0)
+        throw GenotypeStoreException("Failed to write vcf record");
+    }
+  }
+  for (auto& record : records) bcf_destroy(record);
+
+  bcf_hdr_destroy(hdr);
+  if (bcf_close(fout) != 0)
+    throw GenotypeStoreException("Failed to close " + fpath);
+}
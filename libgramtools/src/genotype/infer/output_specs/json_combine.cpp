@@ -0,0 +1,180 @@
+#include "genotype/infer/output_specs/json_combine.hpp"
+
+#include "common/parallel.hpp"
+
+using namespace gram;
+using namespace gram::json;
+
+JsonSiteReader::JsonSiteReader(std::istream& in, std::string name)
+    : in(&in), name(std::move(name)) {
+  expect('{');
+  while (true) {
+    JSON key;
+    *this->in >> key;
+    expect(':');
+    if (key == "Sites") break;
+    *this->in >> header[key.get<std::string>()];
+
+    auto const separator = next_char();
+    if (separator == '}')
+      throw JSONConsistencyException("No Sites entry in " + this->name);
+    if (separator != ',')
+      throw JSONConsistencyException("Malformed JSON: " + this->name);
+  }
+  header["Sites"] = JSON::array();
+
+  expect('[');
+  *this->in >> std::ws;
+  if (this->in->peek() == ']') {
+    this->in->get();
+    expect('}');
+  } else
+    sites_left = true;
+}
+
+char JsonSiteReader::next_char() {
+  *in >> std::ws;
+  auto const result = in->get();
+  if (result == std::char_traits<char>::eof())
+    throw JSONConsistencyException("Unexpected end of " + name);
+  return static_cast<char>(result);
+}
+
+void JsonSiteReader::expect(char expected) {
+  if (next_char() != expected) {
+    if (expected == '}')
+      throw JSONConsistencyException("Sites is not the last entry of " +
+                                     name);
+    throw JSONConsistencyException("Malformed JSON: " + name);
+  }
+}
+
+bool JsonSiteReader::next_site(JSON& site) {
+  if (!sites_left) return false;
+  *in >> site;
+  auto const separator = next_char();
+  if (separator == ']') {
+    sites_left = false;
+    expect('}');
+  } else if (separator != ',')
+    throw JSONConsistencyException("Malformed JSON: " + name);
+  return true;
+}
+
+JSON gram::json::combine_sites(std::vector<JSON> sites,
+                               std::string const& gtyping_model) {
+  if (sites.size() == 1) return std::move(sites.front());
+
+  auto const& first = sites.front();
+  std::string const ref = first.at("ALS").at(0);
+  for (std::size_t i = 1; i < sites.size(); ++i) {
+    for (auto const& entry : singleton_entries) {
+      if (first.at(entry) != sites[i].at(entry)) {
+        std::string msg("Sites do not have same " + entry + ": ");
+        throw JSONCombineException(msg);
+      }
+    }
+    if (ref != sites[i].at("ALS").at(0)) {
+      std::string msg("Sites do not have same 'reference' allele: ");
+      msg = msg + ref + " vs " + std::string(sites[i].at("ALS").at(0));
+      throw JSONCombineException(msg);
+    }
+  }
+
+  std::vector<Json_Site> json_sites;
+  json_sites.reserve(sites.size());
+  for (auto& site : sites) json_sites.emplace_back(std::move(site));
+
+  allele_combi_map m{{ref, site_rescaler{0, 0}}};  // Always place the REF
+  for (auto& json_site : json_sites)
+    json_site.build_allele_combi_map(json_site.get_site(), m);
+  for (auto& json_site : json_sites) json_site.rescale_entries(m);
+
+  auto& result = json_sites.front();
+  result.get_site().at("ALS") = result.get_all_alleles(m);
+  for (std::size_t i = 1; i < json_sites.size(); ++i) {
+    result.append_trivial_entries_from(json_sites[i].get_site());
+    result.add_model_specific_entries_from(json_sites[i].get_site(),
+                                           gtyping_model);
+  }
+  return std::move(result.get_site());
+}
+
+namespace {
+void write_combined_sites(std::vector<JsonSiteReader>& readers,
+                          std::vector<std::size_t> const& num_samples,
+                          std::string const& gtyping_model, std::ostream& out,
+                          std::size_t sites_per_chunk) {
+  auto const num_inputs = readers.size();
+  // Indexed by site in the chunk, then by input
+  std::vector<std::vector<JSON>> chunk(sites_per_chunk,
+                                       std::vector<JSON>(num_inputs));
+  std::vector<std::size_t> num_read(num_inputs);
+  std::vector<std::string> serialised(sites_per_chunk);
+
+  out << '[';
+  bool first_site{true};
+  while (true) {
+    parallel_for(num_inputs, [&](std::size_t i) {
+      std::size_t j{0};
+      while (j < sites_per_chunk && readers[i].next_site(chunk[j][i])) ++j;
+      num_read[i] = j;
+    });
+    auto const chunk_size = num_read.front();
+    for (auto const n : num_read)
+      if (n != chunk_size)
+        throw JSONCombineException(
+            "JSONs do not have the same number of sites");
+
+    parallel_for(chunk_size, [&](std::size_t j) {
+      for (std::size_t i = 1; i < num_inputs; ++i) {
+        if (chunk[j][i].at("GT").size() != num_samples[i])
+          throw JSONConsistencyException(
+              "Merged in JSON does not have number of GT arrays"
+              " consistent with its number of Samples");
+      }
+      serialised[j] =
+          combine_sites(std::move(chunk[j]), gtyping_model).dump();
+      chunk[j] = std::vector<JSON>(num_inputs);
+    });
+
+    for (std::size_t j = 0; j < chunk_size; ++j) {
+      if (!first_site) out << ',';
+      first_site = false;
+      out << serialised[j];
+    }
+    if (chunk_size < sites_per_chunk) break;
+  }
+  out << ']';
+}
+}  // namespace
+
+void gram::json::combine_json_prgs(std::vector<std::istream*> const& inputs,
+                                   std::vector<std::string> const& input_names,
+                                   std::ostream& out,
+                                   std::size_t sites_per_chunk,
+                                   bool force) {
+  if (inputs.empty()) throw JSONCombineException("No JSONs to combine");
+  if (sites_per_chunk == 0) sites_per_chunk = 1;
+
+  std::vector<JsonSiteReader> readers;
+  std::vector<std::size_t> num_samples;
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    readers.emplace_back(*inputs[i], input_names.at(i));
+    num_samples.push_back(readers.back().get_header().at("Samples").size());
+  }
+
+  Json_Prg combined(readers.front().get_header());
+  for (std::size_t i = 1; i < readers.size(); ++i) {
+    auto const& header = readers[i].get_header();
+    combined.check_combinable(header);
+    combined.add_sample_names(header.at("Samples"), force);
+  }
+  std::string const gtyping_model = combined.get_prg().at("Model");
+
+  write_json_with_streamed_sites(
+      out, combined.get_prg(), [&](std::ostream& sites_out) {
+        write_combined_sites(readers, num_samples, gtyping_model, sites_out,
+                             sites_per_chunk);
+      });
+}
@@ -46,11 +46,15 @@ void Json_Prg::add_samples(Json_Prg& other, const bool force) {
         "Merged in JSON does not have number of GT arrays"
         " consistent with its number of Samples");
 
+  add_sample_names(other_prg.at("Samples"), force);
+}
+
+void Json_Prg::add_sample_names(JSON samples, const bool force) {
   std::map<std::string, std::size_t> duplicates;
   for (auto const& e : json_prg.at("Samples"))
     duplicates.insert({e.at("Name"), 1});
 
-  for (auto& sample_entry : other_prg.at("Samples")) {
+  for (auto& sample_entry : samples) {
     std::string const name = sample_entry.at("Name");
     std::string used_name = name;
     if (duplicates.find(name) != duplicates.end()) {
@@ -70,8 +74,7 @@ void Json_Prg::add_samples(Json_Prg& other, const bool force) {
   }
 }
 
-void Json_Prg::combine_with(Json_Prg& other, bool force) {
-  auto other_prg = other.get_prg();
+void Json_Prg::check_combinable(JSON const& other_prg) const {
   if (json_prg.at("Model") != other_prg.at("Model"))
     throw JSONCombineException("JSONs have different models");
 
@@ -84,6 +87,10 @@ void Json_Prg::combine_with(Json_Prg& other, bool force) {
 
   if (json_prg.at("Site_Fields") != other_prg.at("Site_Fields"))
     throw JSONCombineException("Incompatible Site Fields");
+}
+
+void Json_Prg::combine_with(Json_Prg& other, bool force) {
+  check_combinable(other.get_prg());
 
   if (sites.size() != other.sites.size())
     throw JSONCombineException("JSONs do not have the same number of sites");
@@ -96,3 +103,20 @@ void Json_Prg::combine_with(Json_Prg& other, bool force) {
     json_prg.at("Sites").at(j) = sites.at(j)->get_site();
   }
 }
+
+void gram::json::write_json_with_streamed_sites(
+    std::ostream& out, JSON const& header,
+    std::function<void(std::ostream&)> const& write_sites) {
+  bool first_entry{true};
+  out << '{';
+  for (auto const& entry : header.items()) {
+    if (!first_entry) out << ',';
+    first_entry = false;
+    out << JSON(entry.key()).dump() << ':';
+    if (entry.key() == "Sites")
+      write_sites(out);
+    else
+      out << entry.value().dump();
+  }
+  out << '}';
+}
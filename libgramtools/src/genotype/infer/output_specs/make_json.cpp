@@ -1,4 +1,6 @@
 #include "genotype/infer/output_specs/make_json.hpp"
+
+#include "common/parallel.hpp"
 #include "genotype/infer/output_specs/segment_tracker.hpp"
 #include "prg/coverage_graph.hpp"
 
@@ -9,16 +11,62 @@ json_prg_ptr make_json_prg(gtyper_ptr const& gtyper, SegmentTracker& tracker) {
   populate_json_prg(*result, gtyper);
   auto genotyped_records = gtyper->get_genotyped_records();
   for (auto const& site : genotyped_records) {
-    auto json_site = make_json_site(site);
     auto site_pos = site->get_pos();
-    json_site->set_segment(tracker.get_ID(site_pos));
-    json_site->set_pos(tracker.get_relative_pos(site_pos) +
-                       1);  // 0-based to 1-based
-    result->add_site(json_site);
+    auto const& segment_ID = tracker.get_ID(site_pos);
+    result->add_site(make_positioned_json_site(
+        site, segment_ID, tracker.get_relative_pos(site_pos)));
   }
   return result;
 }
 
+void write_json_sites(std::ostream& out, gtyper_ptr const& gtyper,
+                      SegmentTracker& tracker) {
+  auto const& genotyped_records = gtyper->get_genotyped_records();
+  std::size_t const num_sites = genotyped_records.size();
+  std::vector<std::string> segment_IDs(
+      std::min(num_sites, JSON_SITES_PER_CHUNK));
+  std::vector<std::size_t> relative_positions(segment_IDs.size());
+  std::vector<std::string> serialised(segment_IDs.size());
+
+  out << '[';
+  for (std::size_t start = 0; start < num_sites; start += serialised.size()) {
+    auto const chunk_size = std::min(serialised.size(), num_sites - start);
+    // Positions are resolved in order, as the tracker only moves forward
+    for (std::size_t i = 0; i < chunk_size; ++i) {
+      auto site_pos = genotyped_records[start + i]->get_pos();
+      segment_IDs[i] = tracker.get_ID(site_pos);
+      relative_positions[i] = tracker.get_relative_pos(site_pos);
+    }
+
+    gram::parallel_for(chunk_size, [&](std::size_t i) {
+      serialised[i] =
+          make_positioned_json_site(genotyped_records[start + i],
+                                    segment_IDs[i], relative_positions[i])
+              ->get_site()
+              .dump();
+    });
+
+    for (std::size_t i = 0; i < chunk_size; ++i) {
+      if (start + i > 0) out << ',';
+      out << serialised[i];
+    }
+  }
+  out << ']';
+}
+
+void write_json_prg(std::ostream& out, gtyper_ptr const& gtyper,
+                    SegmentTracker& tracker, std::string const& sample_name,
+                    std::string const& sample_desc) {
+  Json_Prg json_prg;
+  populate_json_prg(json_prg, gtyper);
+  json_prg.set_sample_info(sample_name, sample_desc);
+
+  write_json_with_streamed_sites(
+      out, json_prg.get_prg(), [&](std::ostream& sites_out) {
+        write_json_sites(sites_out, gtyper, tracker);
+      });
+}
+
 void populate_json_prg(Json_Prg& json_prg, gtyper_ptr const& gtyper) {
   auto& cur_json = json_prg.get_prg();
   auto cov_graph = gtyper->get_cov_g();
@@ -80,3 +128,12 @@ json_site_ptr make_json_site(gt_site_ptr const& gt_site) {
 
   return result;
 }
+
+json_site_ptr make_positioned_json_site(gt_site_ptr const& gt_site,
+                                        std::string const& segment_ID,
+                                        std::size_t relative_pos) {
+  auto result = make_json_site(gt_site);
+  result->set_segment(segment_ID);
+  result->set_pos(relative_pos + 1);  // 0-based to 1-based
+  return result;
+}
@@ -1,5 +1,6 @@
 #include "genotype/infer/output_specs/make_vcf.hpp"
 #include <htslib/synced_bcf_reader.h>
+#include "common/parallel.hpp"
 #include "genotype/infer/output_specs/fields.hpp"
 #include "genotype/infer/output_specs/segment_tracker.hpp"
 #include "prg/coverage_graph.hpp"
@@ -7,6 +8,10 @@
 void write_vcf(gram::GenotypeParams const& params, gtyper_ptr const& gtyper,
                SegmentTracker& tracker) {
   auto fout = bcf_open(params.genotyped_vcf_fpath.c_str(), "wz");  // Writer
+  if (fout == nullptr)
+    throw VcfWriteException("Could not open " + params.genotyped_vcf_fpath);
+  // BGZF blocks get compressed by a pool of threads
+  if (params.maximum_threads > 1) hts_set_threads(fout, params.maximum_threads);
 
   // Set up and write header
   bcf_hdr_t* header = bcf_hdr_init("w");
@@ -16,7 +21,9 @@ void write_vcf(gram::GenotypeParams const& params, gtyper_ptr const& gtyper,
 
   write_sites(fout, header, gtyper, tracker);
 
-  bcf_close(fout);
+  bcf_hdr_destroy(header);
+  if (bcf_close(fout) != 0)
+    throw VcfWriteException("Failed to close " + params.genotyped_vcf_fpath);
 }
 
 void populate_vcf_hdr(bcf_hdr_t* hdr, gtyper_ptr gtyper,
@@ -61,22 +68,42 @@ std::size_t next_valid_idx(std::size_t idx, std::size_t max_size,
 
 void write_sites(htsFile* fout, bcf_hdr_t* header, gtyper_ptr const& gtyper,
                  SegmentTracker& tracker) {
-  auto p_map = gtyper->get_cov_g()->par_map;
-  auto genotyped_records = gtyper->get_genotyped_records();
-  std::size_t site_idx{0}, max_size{genotyped_records.size()};
-  // Set up and write records
-  bcf1_t* record = bcf_init();
-
-  while (true) {
-    site_idx = next_valid_idx(site_idx, max_size, p_map);
-    if (site_idx >= max_size) break;
-
-    bcf_empty(record);
-    populate_vcf_site(header, record, genotyped_records[site_idx], tracker);
-    if (bcf_write(fout, header, record) != 0)
-      throw VcfWriteException("Failed to write vcf record");
-    site_idx++;
+  auto const& p_map = gtyper->get_cov_g()->par_map;
+  auto const& genotyped_records = gtyper->get_genotyped_records();
+  std::size_t const max_size{genotyped_records.size()};
+  std::vector<std::size_t> site_indices;
+  for (auto site_idx = next_valid_idx(0, max_size, p_map); site_idx < max_size;
+       site_idx = next_valid_idx(site_idx + 1, max_size, p_map))
+    site_indices.push_back(site_idx);
+
+  // Records get populated in parallel, one chunk at a time, and written in
+  // site order. This bounds the number of records held in memory.
+  std::vector<bcf1_t*> records(
+      std::min(site_indices.size(), VCF_RECORDS_PER_CHUNK));
+  for (auto& record : records) record = bcf_init();
+
+  for (std::size_t start = 0; start < site_indices.size();
+       start += records.size()) {
+    auto const chunk_size =
+        std::min(records.size(), site_indices.size() - start);
+    // Positions are resolved in order, as the tracker only moves forward
+    for (std::size_t i = 0; i < chunk_size; ++i) {
+      bcf_empty(records[i]);
+      set_vcf_position(header, records[i],
+                       genotyped_records[site_indices[start + i]], tracker);
+    }
+
+    gram::parallel_for(chunk_size, [&](std::size_t i) {
+      populate_vcf_entries(header, records[i],
+                           genotyped_records[site_indices[start + i]]);
+    });
+
+    for (std::size_t i = 0; i < chunk_size; ++i) {
+      if (bcf_write(fout, header, records[i]) != 0)
+        throw VcfWriteException("Failed to write vcf record");
+    }
   }
+  for (auto& record : records) bcf_destroy(record);
 }
 
 void add_model_specific_entries(bcf_hdr_t* hdr, bcf1_t* record,
@@ -91,14 +118,23 @@ void add_model_specific_entries(bcf_hdr_t* hdr, bcf1_t* record,
 
 void populate_vcf_site(bcf_hdr_t* header, bcf1_t* record, gt_site_ptr site,
                        SegmentTracker& tracker) {
-  using str_vec = std::vector<std::string>;
+  set_vcf_position(header, record, site, tracker);
+  populate_vcf_entries(header, record, site);
+}
 
+void set_vcf_position(bcf_hdr_t* header, bcf1_t* record,
+                      gt_site_ptr const& site, SegmentTracker& tracker) {
   // Set CHROM
   auto numeric_id =
       bcf_hdr_name2id(header, tracker.get_ID(site->get_pos()).c_str());
   record->rid = numeric_id;
   // Set POS. Pass in a 0-based
   record->pos = tracker.get_relative_pos(site->get_pos());
+}
+
+void populate_vcf_entries(bcf_hdr_t* header, bcf1_t* record,
+                          gt_site_ptr const& site) {
+  using str_vec = std::vector<std::string>;
 
   // Set GT
   auto gtype_info = site->get_all_gtype_info();
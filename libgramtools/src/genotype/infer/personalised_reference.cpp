@@ -1,14 +1,17 @@
 #include "genotype/infer/personalised_reference.hpp"
+#include <htslib/bgzf.h>
+#include <algorithm>
+#include <fstream>
+#include <string_view>
+#include <unordered_set>
 #include <genotype/infer/output_specs/segment_tracker.hpp>
 #include "genotype/infer/interfaces.hpp"
 #include "prg/coverage_graph.hpp"
 
 namespace gram::genotype {
 
-allele_vector get_all_alleles_to_paste(gt_site_ptr const& site,
-                                       std::size_t ploidy) {
-  allele_vector result(ploidy);
-  auto all_site_alleles = site->get_alleles();
+GtypedIndices get_genotype_to_paste(gt_site_ptr const& site,
+                                    std::size_t ploidy) {
   GtypedIndices gts;
   if (site->is_null())
     gts = GtypedIndices(ploidy, 0);
@@ -16,7 +19,14 @@ allele_vector get_all_alleles_to_paste(gt_site_ptr const& site,
     gts = site->get_genotype();
 
   if (gts.size() != ploidy) throw InconsistentPloidyException();
+  return gts;
+}
 
+allele_vector get_all_alleles_to_paste(gt_site_ptr const& site,
+                                       std::size_t ploidy) {
+  allele_vector result(ploidy);
+  auto const& all_site_alleles = site->get_alleles();
+  auto const gts = get_genotype_to_paste(site, ploidy);
   for (int j{0}; j < ploidy; j++) result.at(j) = all_site_alleles.at(gts.at(j));
 
   return result;
@@ -59,18 +69,16 @@ std::size_t switch_segment(Fastas& p_refs, std::size_t& offset,
   return tracker.edge();
 }
 
-// Helper function for get_personalised_ref()
-void add_invariant_sequence(Fastas& p_refs, std::size_t const offset,
-                            std::size_t const ploidy, std::string const seq) {
-  for (int i{0}; i < ploidy; i++) p_refs.at(i + offset).add_sequence(seq);
-}
-
-Fastas get_personalised_ref(covG_ptr graph_root,
-                            gt_sites const& genotyped_records,
-                            SegmentTracker& tracker) {
-  auto ploidy = get_ploidy(genotyped_records);
-  auto num_segments = tracker.num_segments();
-  Fastas p_refs(num_segments * ploidy);
+/**
+ * Helper function for get_personalised_ref(): walks the graph, calling
+ * `paste(p_ref_index, sequence, start, length)` for each piece of sequence of
+ * each personalised reference, in order. Also sets the Fasta IDs.
+ */
+template <typename Paste>
+void walk_personalised_ref(covG_ptr graph_root,
+                           gt_sites const& genotyped_records,
+                           SegmentTracker& tracker, std::size_t const ploidy,
+                           Fastas& p_refs, Paste paste) {
   gram::covG_ptr cur_Node{graph_root};
 
   std::size_t offset{0};
@@ -80,10 +88,13 @@ Fastas get_personalised_ref(covG_ptr graph_root,
   while (cur_Node->get_edges().size() > 0) {
     if (cur_Node->is_bubble_start()) {
       auto site_index = siteID_to_index(cur_Node->get_site_ID());
-      auto site = genotyped_records.at(site_index);
-      auto to_paste_alleles = get_all_alleles_to_paste(site, ploidy);
-      for (int i{0}; i < ploidy; i++)
-        p_refs.at(i + offset).add_sequence(to_paste_alleles.at(i).sequence);
+      auto const& site = genotyped_records.at(site_index);
+      auto const& alleles = site->get_alleles();
+      auto const gts = get_genotype_to_paste(site, ploidy);
+      for (int i{0}; i < ploidy; i++) {
+        auto const& sequence = alleles.at(gts.at(i)).sequence;
+        paste(i + offset, sequence, 0, sequence.size());
+      }
 
       cur_Node = site->get_site_end_node();
       if (cur_edge == cur_Node->get_pos() - 1)
@@ -91,29 +102,49 @@ Fastas get_personalised_ref(covG_ptr graph_root,
     }
 
     if (cur_Node->has_sequence()) {
-      std::size_t cur_pos = cur_Node->get_pos();
+      std::size_t const node_pos = cur_Node->get_pos();
+      std::size_t cur_pos = node_pos;
       std::size_t end_pos = cur_pos + cur_Node->get_sequence_size() - 1;
-      auto sequence = cur_Node->get_sequence();
+      auto const& sequence = cur_Node->get_sequence();
       while (cur_pos <= end_pos) {
-        if (cur_edge <= end_pos) {
-          add_invariant_sequence(p_refs, offset, ploidy,
-                                 sequence.substr(cur_pos - cur_Node->get_pos(),
-                                                 cur_edge - cur_pos + 1));
-          cur_pos = cur_edge + 1;
+        auto const last_pos = std::min(cur_edge, end_pos);
+        for (int i{0}; i < ploidy; i++)
+          paste(i + offset, sequence, cur_pos - node_pos,
+                last_pos - cur_pos + 1);
+        cur_pos = last_pos + 1;
+        if (cur_edge <= end_pos)
           cur_edge = switch_segment(p_refs, offset, ploidy, tracker);
-        } else {
-          add_invariant_sequence(
-              p_refs, offset, ploidy,
-              sequence.substr(cur_pos - cur_Node->get_pos()));
-          cur_pos = end_pos + 1;
-        }
       }
     }
 
     assert(cur_Node->get_edges().size() == 1);
     cur_Node = cur_Node->get_edges().at(0);
   }
+}
 
+Fastas get_personalised_ref(covG_ptr graph_root,
+                            gt_sites const& genotyped_records,
+                            SegmentTracker& tracker) {
+  auto ploidy = get_ploidy(genotyped_records);
+  auto num_segments = tracker.num_segments();
+  Fastas p_refs(num_segments * ploidy);
+
+  // The sizing pass uses a copy of the tracker, as trackers only move forward
+  std::vector<std::size_t> sizes(p_refs.size(), 0);
+  SegmentTracker sizing_tracker{tracker};
+  walk_personalised_ref(graph_root, genotyped_records, sizing_tracker, ploidy,
+                        p_refs,
+                        [&sizes](std::size_t i, std::string const&,
+                                 std::size_t, std::size_t length) {
+                          sizes.at(i) += length;
+                        });
+  for (std::size_t i{0}; i < p_refs.size(); i++) p_refs[i].reserve(sizes[i]);
+
+  walk_personalised_ref(graph_root, genotyped_records, tracker, ploidy, p_refs,
+                        [&p_refs](std::size_t i, std::string const& sequence,
+                                  std::size_t start, std::size_t length) {
+                          p_refs.at(i).add_sequence(sequence, start, length);
+                        });
   return p_refs;
 }
 
@@ -121,11 +152,14 @@ bool operator<(const Fasta& first, const Fasta& second) {
   return first.sequence < second.sequence;
 }
 
+std::string Fasta::header_line() const {
+  std::string result = '>' + ID + " " + desc;
+  if (desc.empty() || desc.back() != '\n') result.push_back('\n');
+  return result;
+}
+
 std::ostream& operator<<(std::ostream& out_stream, const Fasta& input) {
-  out_stream << '>' << input.ID << " " << input.desc;
-  if (input.desc.back() != '\n') {
-    out_stream << std::endl;
-  }
+  out_stream << input.header_line();
 
   auto seq_write = input.sequence.c_str();
   auto remaining = input.sequence.size();
@@ -133,7 +167,7 @@ std::ostream& operator<<(std::ostream& out_stream, const Fasta& input) {
     out_stream.write(seq_write, FASTA_LWIDTH);
     seq_write += FASTA_LWIDTH;
     remaining -= FASTA_LWIDTH;
-    out_stream << std::endl;
+    out_stream << '\n';
   }
 
   out_stream.write(seq_write, remaining);
@@ -148,4 +182,107 @@ void add_description(Fastas& p_refs, std::string const& desc) {
   }
 }
 
+Fastas dedupe_sequences(Fastas fastas) {
+  std::vector<bool> keep(fastas.size());
+  {
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(fastas.size());
+    for (std::size_t i{0}; i < fastas.size(); i++)
+      keep[i] = seen.insert(fastas[i].get_sequence()).second;
+  }
+  Fastas result;
+  for (std::size_t i{0}; i < fastas.size(); i++)
+    if (keep[i]) result.push_back(std::move(fastas[i]));
+  return result;
+}
+
+namespace {
+/**
+ * Writes plain or bgzipped output, keeping count of the (uncompressed) bytes
+ * written for the .fai index.
+ */
+class FastaWriter {
+  std::string fpath;
+  std::ofstream plain_out;
+  BGZF* bgzf_out{nullptr};
+
+ public:
+  std::size_t offset{0};
+
+  FastaWriter(std::string const& fpath, bool bgzip, std::size_t num_threads)
+      : fpath(fpath) {
+    if (!bgzip) {
+      plain_out.open(fpath);
+      if (!plain_out.good())
+        throw FastaWriteException("Could not open " + fpath);
+      return;
+    }
+    bgzf_out = bgzf_open(fpath.c_str(), "w");
+    if (bgzf_out == nullptr)
+      throw FastaWriteException("Could not open " + fpath);
+    if (num_threads > 1) bgzf_mt(bgzf_out, num_threads, 256);
+    if (bgzf_index_build_init(bgzf_out) != 0)
+      throw FastaWriteException("Could not index " + fpath);
+  }
+  ~FastaWriter() {
+    if (bgzf_out != nullptr) bgzf_close(bgzf_out);
+  }
+
+  void write(std::string const& data) {
+    if (bgzf_out == nullptr)
+      plain_out.write(data.data(), data.size());
+    else if (bgzf_write(bgzf_out, data.data(), data.size()) < 0)
+      throw FastaWriteException("Failed to write to " + fpath);
+    offset += data.size();
+  }
+
+  void close() {
+    if (bgzf_out == nullptr) {
+      plain_out.close();
+      if (plain_out.fail())
+        throw FastaWriteException("Failed to write to " + fpath);
+      return;
+    }
+    auto const dump_failed = bgzf_index_dump(bgzf_out, fpath.c_str(), ".gzi");
+    auto const close_failed = bgzf_close(bgzf_out);
+    bgzf_out = nullptr;
+    if (dump_failed != 0 || close_failed != 0)
+      throw FastaWriteException("Failed to write to " + fpath);
+  }
+};
+}  // namespace
+
+void write_fastas(Fastas const& fastas, std::string const& fpath, bool bgzip,
+                  std::size_t num_threads) {
+  FastaWriter writer(fpath, bgzip, num_threads);
+  std::ofstream fai_out(fpath + ".fai");
+  if (!fai_out.good()) throw FastaWriteException("Could not open " + fpath);
+
+  std::string buffer;
+  buffer.reserve(FASTA_WRITE_BUFFER_SIZE + FASTA_LWIDTH + 1);
+  for (auto const& fasta : fastas) {
+    buffer += fasta.header_line();
+    auto const& sequence = fasta.get_sequence();
+    std::size_t const line_bases =
+        std::min<std::size_t>(sequence.size(), FASTA_LWIDTH);
+    fai_out << fasta.get_ID() << '\t' << sequence.size() << '\t'
+            << writer.offset + buffer.size() << '\t' << line_bases << '\t'
+            << line_bases + 1 << '\n';
+
+    for (std::size_t pos{0}; pos < sequence.size(); pos += FASTA_LWIDTH) {
+      buffer.append(sequence, pos, FASTA_LWIDTH);
+      buffer.push_back('\n');
+      if (buffer.size() >= FASTA_WRITE_BUFFER_SIZE) {
+        writer.write(buffer);
+        buffer.clear();
+      }
+    }
+    if (sequence.empty()) buffer.push_back('\n');
+  }
+  writer.write(buffer);
+  writer.close();
+  fai_out.close();
+  if (fai_out.fail()) throw FastaWriteException("Failed to write .fai index");
+}
+
 }  // namespace gram::genotype
@@ -42,6 +42,33 @@ void validate(boost::any& v, const std::vector<std::string>& values,
   v = boost::any(ploidy_argument(s));
 }
 
+struct repetitive_reads_argument {
+  RepetitiveReadsPolicy policy;
+
+ public:
+  repetitive_reads_argument() = default;
+  repetitive_reads_argument(const std::string& in) {
+    if (in == "downsample")
+      policy = RepetitiveReadsPolicy::Downsample;
+    else if (in == "skip")
+      policy = RepetitiveReadsPolicy::Skip;
+    else
+      throw std::invalid_argument("Invalid repetitive reads policy");
+  }
+
+  RepetitiveReadsPolicy get() { return policy; }
+};
+
+void validate(boost::any& v, const std::vector<std::string>& values,
+              repetitive_reads_argument* target_type, int) {
+  using namespace boost::program_options;
+
+  validators::check_first_occurrence(v);
+  std::string const& s = validators::get_single_string(values);
+
+  v = boost::any(repetitive_reads_argument(s));
+}
+
 GenotypeParams commands::genotype::parse_parameters(
     po::variables_map& vm, const po::parsed_options& parsed) {
   GenotypeParams parameters = {};
@@ -49,15 +76,28 @@ GenotypeParams commands::genotype::parse_parameters(
   std::string run_dirpath;
   ploidy_argument ploidy;
   Seed::value_type seed;
+  repetitive_reads_argument repetitive_reads{"skip"};
 
   po::options_description genotype_description("genotype options");
   genotype_description.add_options()(
       "gram_dir", po::value<std::string>(&parameters.gram_dirpath)->required(),
       "gramtools directory")("reads",
                              po::value<std::vector<std::string>>(&reads_fpaths)
-                                 ->multitoken()
-                                 ->required(),
+                                 ->multitoken(),
                              "file containing reads (FASTA or FASTQ)")(
+      "from_checkpoint",
+      po::value<std::string>(&parameters.input_checkpoint_fpath),
+      "coverage checkpoint from a previous run on the same prg: genotype "
+      "from it instead of mapping reads")(
+      "stop_after_mapping",
+      po::bool_switch(&parameters.stop_after_mapping),
+      "only map reads and write coverage, including the coverage checkpoint")(
+      "gzip_coverage", po::bool_switch(&parameters.gzip_coverage),
+      "gzip the coverage files (not the coverage checkpoint)")(
+      "bgzip_personalised_ref",
+      po::bool_switch(&parameters.bgzip_personalised_ref),
+      "bgzip the personalised reference, and index it with a .gzi file as "
+      "well as a .fai file")(
       "sample_id", po::value<std::string>(&parameters.sample_id)->required())(
       "ploidy", po::value<ploidy_argument>(&ploidy)->required(),
       "expected ploidy of the sample. Choices: {haploid, diploid}")(
@@ -69,7 +109,25 @@ GenotypeParams commands::genotype::parse_parameters(
                           "maximum number of threads used")(
       "seed", po::value<SeedSize>(&seed),
       "seed for pseudo-random selection of multi-mapping reads. "
-      "a random seed is generated if this option is not used.");
+      "a random seed is generated if this option is not used.")(
+      "max_read_occurrences",
+      po::value<uint64_t>(&parameters.max_read_occurrences)->default_value(0),
+      "maximum number of occurrences of a read in the prg; reads with more "
+      "occurrences are treated as repetitive. 0 means no maximum.")(
+      "repetitive_reads",
+      po::value<repetitive_reads_argument>(&repetitive_reads),
+      "what to do with repetitive reads. Choices: {skip, downsample}. "
+      "skip: the read is not used; downsample: a subset of its occurrences "
+      "is used. Default: skip")(
+      "gcp_cache_dir", po::value<std::string>(&parameters.gcp_cache_dirpath),
+      "directory in which to cache the simulated genotype confidences used "
+      "for confidence percentiles. Coverage depth and error rate get rounded "
+      "to a grid with 5% steps; runs with the same ploidy and rounded values "
+      "reuse them.")(
+      "genotype_store",
+      po::value<std::string>(&parameters.genotype_store_dirpath),
+      "genotype store (directory) to append the genotyped sample to. It is "
+      "created if it does not exist.");
 
   std::vector<std::string> opts =
       po::collect_unrecognized(parsed.options, po::include_positional);
@@ -79,6 +137,13 @@ GenotypeParams commands::genotype::parse_parameters(
     po::store(po::command_line_parser(opts).options(genotype_description).run(),
               vm);
     po::notify(vm);
+    bool const from_checkpoint = !parameters.input_checkpoint_fpath.empty();
+    if (from_checkpoint == !reads_fpaths.empty())
+      throw std::invalid_argument(
+          "exactly one of --reads and --from_checkpoint must be given");
+    if (from_checkpoint && parameters.stop_after_mapping)
+      throw std::invalid_argument(
+          "--stop_after_mapping cannot be used with --from_checkpoint");
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     std::cout << genotype_description << std::endl;
@@ -86,10 +151,20 @@ GenotypeParams commands::genotype::parse_parameters(
   }
 
   fill_common_parameters(parameters, parameters.gram_dirpath);
+  if (!parameters.input_checkpoint_fpath.empty())
+    parameters.input_checkpoint_fpath =
+        fs::absolute(fs::path(parameters.input_checkpoint_fpath)).string();
+  if (!parameters.gcp_cache_dirpath.empty())
+    parameters.gcp_cache_dirpath =
+        fs::absolute(fs::path(parameters.gcp_cache_dirpath)).string();
+  if (!parameters.genotype_store_dirpath.empty())
+    parameters.genotype_store_dirpath =
+        fs::absolute(fs::path(parameters.genotype_store_dirpath)).string();
   for (auto& elem : reads_fpaths) elem = fs::absolute(fs::path(elem)).string();
   parameters.reads_fpaths = reads_fpaths;
 
   parameters.ploidy = ploidy.get();
+  parameters.repetitive_reads_policy = repetitive_reads.get();
 
   std::string cov_dirpath = mkdir(run_dirpath, "coverage");
   std::string geno_dirpath = mkdir(run_dirpath, "genotype");
@@ -103,11 +178,20 @@ GenotypeParams commands::genotype::parse_parameters(
       full_path(cov_dirpath, "allele_base_coverage.json");
   parameters.grouped_allele_counts_fpath =
       full_path(cov_dirpath, "grouped_allele_counts_coverage.json");
+  parameters.coverage_checkpoint_fpath =
+      full_path(cov_dirpath, "coverage_checkpoint.bin");
+  if (parameters.gzip_coverage) {
+    parameters.allele_sum_coverage_fpath += ".gz";
+    parameters.allele_base_coverage_fpath += ".gz";
+    parameters.grouped_allele_counts_fpath += ".gz";
+  }
 
   parameters.genotyped_json_fpath = full_path(geno_dirpath, "genotyped.json");
   parameters.genotyped_vcf_fpath = full_path(geno_dirpath, "genotyped.vcf.gz");
   parameters.personalised_ref_fpath =
       full_path(geno_dirpath, "personalised_reference.fasta");
+  if (parameters.bgzip_personalised_ref)
+    parameters.personalised_ref_fpath += ".gz";
 
   parameters.maximum_threads = vm["max_threads"].as<uint32_t>();
   omp_set_num_threads(parameters.maximum_threads);
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "genotype/quasimap/coverage/allele_base.hpp"
+#include "common/file_write.hpp"
 
 using namespace gram;
 using namespace gram::coverage::per_base;
@@ -40,70 +41,65 @@ SitesAlleleBaseCoverage gram::coverage::generate::allele_base_non_nested(
 void coverage::record::allele_base(PRG_Info const &prg_info,
                                    const SearchStates &search_states,
                                    const uint64_t &read_length) {
-  PbCovRecorder record_it{prg_info, search_states, read_length};
+  // One recorder per thread, so its scratch storage is reused across reads
+  static thread_local PbCovRecorder recorder;
+  recorder.record(prg_info, search_states, read_length);
 }
 
 /**
- * String serialise the base coverages for one allele.
+ * Serialise the base coverages for one allele.
  */
-std::string dump_allele(const PerBaseCoverage &allele) {
-  std::stringstream stream;
-  stream << "[";
-  auto i = 0;
+void write_allele(std::ostream &out, const PerBaseCoverage &allele) {
+  out << "[";
+  bool first{true};
   for (const auto &base_coverage : allele) {
-    stream << (int)base_coverage;
-    if (i++ < allele.size() - 1) stream << ",";
+    if (!first) out << ",";
+    out << (int)base_coverage;
+    first = false;
   }
-  stream << "]";
-  return stream.str();
+  out << "]";
 }
 
 /**
- * String serialise the alleles of a site.
- * @see dump_allele()
+ * Serialise the alleles of a site.
+ * @see write_allele()
  */
-std::string dump_site(const SitePbCoverage &site) {
-  std::stringstream stream;
-  auto i = 0;
+void write_site(std::ostream &out, const SitePbCoverage &site) {
+  bool first{true};
   for (const auto &allele : site) {
-    stream << dump_allele(allele);
-    if (i++ < site.size() - 1) stream << ",";
+    if (!first) out << ",";
+    write_allele(out, allele);
+    first = false;
   }
-  return stream.str();
 }
 
-/**
- * String serialise all base-level coverages for all sites of the prg.
- * @see dump_site()
- */
-std::string dump_sites(const SitesAlleleBaseCoverage &sites) {
-  std::stringstream stream;
-  auto i = 0;
+void gram::write_allele_base_coverage(std::ostream &out,
+                                      const SitesAlleleBaseCoverage &sites) {
+  out << "{\"allele_base_counts\":[";
+  bool first{true};
   for (const auto &site : sites) {
-    stream << "[";
-    stream << dump_site(site);
-    stream << "]";
-    if (i++ < sites.size() - 1) stream << ",";
+    if (!first) out << ",";
+    out << "[";
+    write_site(out, site);
+    out << "]";
+    first = false;
   }
-  return stream.str();
+  out << "]}";
 }
 
 std::string gram::dump_allele_base_coverage(
     const SitesAlleleBaseCoverage &sites) {
   std::stringstream stream;
-  stream << "{\"allele_base_counts\":[";
-  stream << dump_sites(sites);
-  stream << "]}";
+  write_allele_base_coverage(stream, sites);
   return stream.str();
 }
 
 void coverage::dump::allele_base(const Coverage &coverage,
                                  const GenotypeParams &parameters) {
-  std::string json_string =
-      dump_allele_base_coverage(coverage.allele_base_coverage);
-  std::ofstream file;
-  file.open(parameters.allele_base_coverage_fpath);
-  file << json_string << std::endl;
+  OutputFile file{parameters.allele_base_coverage_fpath,
+                  parameters.gzip_coverage};
+  write_allele_base_coverage(file.stream(), coverage.allele_base_coverage);
+  file.stream() << std::endl;
 }
 
 DummyCovNode::DummyCovNode(node_coordinate start_pos, node_coordinate end_pos,
@@ -134,10 +130,53 @@ void DummyCovNode::extend_coordinates(node_coordinates coords) {
   if (end_pos - start_pos == node_size - 1) full = true;
 }
 
-Traverser::Traverser(node_access start_point, VariantSitePath traversed_loci,
+std::size_t realCov_to_dummyCov::find_position(
+    coverage_Node const *node) const {
+  if (entries.size() > linear_find_max_entries) {
+    auto found = index.find(node);
+    return found == index.end() ? entries.size() : found->second;
+  }
+  std::size_t position{0};
+  while (position < entries.size() && entries[position].first != node)
+    ++position;
+  return position;
+}
+
+DummyCovNode *realCov_to_dummyCov::find(coverage_Node const *node) {
+  auto const position = find_position(node);
+  return position == entries.size() ? nullptr : &entries[position].second;
+}
+
+DummyCovNode const *realCov_to_dummyCov::find(coverage_Node const *node) const {
+  auto const position = find_position(node);
+  return position == entries.size() ? nullptr : &entries[position].second;
+}
+
+void realCov_to_dummyCov::insert(covG_raw_ptr node,
+                                 DummyCovNode const &dummy_node) {
+  entries.emplace_back(node, dummy_node);
+  if (entries.size() <= linear_find_max_entries) return;
+  if (index.empty()) {
+    for (std::size_t position = 0; position < entries.size(); ++position)
+      index.emplace(entries[position].first, position);
+  } else
+    index.emplace(node, entries.size() - 1);
+}
+
+bool realCov_to_dummyCov::operator==(realCov_to_dummyCov const &other) const {
+  if (entries.size() != other.entries.size()) return false;
+  for (auto const &entry : entries) {
+    auto other_dummy = other.find(entry.first);
+    if (other_dummy == nullptr || !(*other_dummy == entry.second)) return false;
+  }
+  return true;
+}
+
+Traverser::Traverser(node_access const &start_point,
+                     VariantSitePath const &traversed_loci,
                      std::size_t read_size)
-    : cur_Node(start_point.node),
-      traversed_loci(traversed_loci),
+    : cur_Node(start_point.node.get()),
+      traversed_loci(&traversed_loci),
       bases_remaining(read_size),
       first_node(true),
       end_pos(0) {
@@ -146,7 +185,7 @@ Traverser::Traverser(node_access start_point, VariantSitePath traversed_loci,
   start_pos = start_point.offset;
 }
 
-std::optional<covG_ptr> Traverser::next_Node() {
+std::optional<covG_raw_ptr> Traverser::next_Node() {
   if (first_node) {
     process_first_node();
     first_node = false;
@@ -193,7 +232,7 @@ void Traverser::update_coordinates() {
 
 void Traverser::move_past_single_edge_node() {
   assert(cur_Node->get_edges().size() == 1);
-  cur_Node = cur_Node->get_edges()[0];
+  cur_Node = cur_Node->get_edges()[0].get();
 }
 
 void Traverser::assign_end_position() {
@@ -204,10 +243,10 @@ void Traverser::assign_end_position() {
 }
 
 void Traverser::choose_allele() {
-  auto traversed_locus = traversed_loci[traversed_index];
+  auto const &traversed_locus = (*traversed_loci)[traversed_index];
   auto site_id{traversed_locus.first};
   auto allele_id{traversed_locus.second};
-  auto next_node = cur_Node->get_edges()[allele_id];
+  auto next_node = cur_Node->get_edges()[allele_id].get();
 
   // Check site & allele consistency
   if (next_node->has_sequence()) {
@@ -220,15 +259,23 @@ void Traverser::choose_allele() {
 
 PbCovRecorder::PbCovRecorder(const PRG_Info &prg_info,
                              SearchStates const &search_states,
-                             std::size_t read_size)
-    : prg_info(&prg_info), read_size(read_size) {
+                             std::size_t read_size) {
+  record(prg_info, search_states, read_size);
+}
+
+void PbCovRecorder::record(PRG_Info const &prg_info,
+                           SearchStates const &search_states,
+                           std::size_t read_size) {
+  this->prg_info = &prg_info;
+  this->read_size = read_size;
+  cov_mapping.clear();
   for (auto const &search_state : search_states)
     process_SearchState(search_state);
   write_coverage_from_dummy_nodes();
 }
 
 void PbCovRecorder::write_coverage_from_dummy_nodes() {
-  covG_ptr cov_node;
+  covG_raw_ptr cov_node;
   node_coordinates to_increment;
   for (auto const &element : cov_mapping) {  // Go through each dummy node
     cov_node = element.first;
@@ -250,7 +297,8 @@ void PbCovRecorder::process_SearchState(SearchState const &ss) {
   for (auto occurrence = ss.sa_interval.first;
        occurrence <= ss.sa_interval.second; occurrence++) {
     auto coordinate = prg_info->fm_index[occurrence];
-    auto access_point = prg_info->coverage_graph.random_access[coordinate];
+    auto const &access_point =
+        prg_info->coverage_graph.random_access[coordinate];
     t = {access_point, ss.traversed_path, read_size};
 
     // Record a full traversal starting at the first mapping instance
@@ -279,18 +327,18 @@ void PbCovRecorder::record_full_traversal(Traverser &t) {
   }
 }
 
-void PbCovRecorder::process_Node(covG_ptr cov_node, node_coordinate start_pos,
+void PbCovRecorder::process_Node(covG_raw_ptr cov_node,
+                                 node_coordinate start_pos,
                                  node_coordinate end_pos) {
   if (!cov_node->has_sequence())
     return;  // Skips double site entries, where `cov_node` is a no-sequence
              // bubble entry
-  if (cov_mapping.find(cov_node) == cov_mapping.end()) {
+  auto existing_dummy_cov_node = cov_mapping.find(cov_node);
+  if (existing_dummy_cov_node == nullptr) {
     std::size_t cov_node_size = cov_node->get_sequence_size();
     DummyCovNode new_dummy_cov_node{start_pos, end_pos, cov_node_size};
-    cov_mapping.insert({cov_node, new_dummy_cov_node});
-  } else {
-    DummyCovNode &existing_dummy_cov_node = cov_mapping.at(cov_node);
-    existing_dummy_cov_node.extend_coordinates(
+    cov_mapping.insert(cov_node, new_dummy_cov_node);
+  } else
+    existing_dummy_cov_node->extend_coordinates(
         node_coordinates{start_pos, end_pos});
-  }
 }
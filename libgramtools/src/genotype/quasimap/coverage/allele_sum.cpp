@@ -4,6 +4,7 @@
 
 #include "genotype/quasimap/coverage/allele_sum.hpp"
 #include "genotype/quasimap/coverage/coverage_common.hpp"
+#include "common/file_write.hpp"
 
 using namespace gram;
 
@@ -44,7 +45,9 @@ void gram::coverage::record::allele_sum(Coverage &coverage,
 
 void gram::coverage::dump::allele_sum(const Coverage &coverage,
                                       const GenotypeParams &parameters) {
-  std::ofstream file_handle(parameters.allele_sum_coverage_fpath);
+  OutputFile file{parameters.allele_sum_coverage_fpath,
+                  parameters.gzip_coverage};
+  auto &file_handle = file.stream();
   for (const auto &variant_site_coverage : coverage.allele_sum_coverage) {
     auto allele_count = 0;
     for (const auto &sum_coverage : variant_site_coverage) {
@@ -53,6 +56,6 @@ void gram::coverage::dump::allele_sum(const Coverage &coverage,
           allele_count++ < variant_site_coverage.size() - 1;
       if (not_last_coverage) file_handle << " ";
     }
-    file_handle << std::endl;
+    file_handle << "\n";  // Not std::endl: no flush after every site
   }
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "genotype/quasimap/coverage/checkpoint.hpp"
+
+#include <fstream>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/unordered_map.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "genotype/quasimap/coverage/allele_base.hpp"
+
+using namespace gram;
+
+std::vector<coverage_Node *> gram::coverage_nodes(
+    coverage_Graph const &cov_graph) {
+  std::vector<coverage_Node *> result;
+  coverage_Node *previous{nullptr};
+  // A node's characters are contiguous in the PRG, so skipping repeats of the
+  // previous node is enough to visit each node once.
+  for (auto const &access_point : cov_graph.random_access) {
+    auto node = access_point.node.get();
+    if (node == previous) continue;
+    previous = node;
+    if (node->get_coverage_space() > 0) result.push_back(node);
+  }
+  return result;
+}
+
+namespace {
+/**
+ * Checkpoint layout: header (version, number of sites, number of nodes),
+ * allele sums, grouped allele counts, per-node coverage, read stats.
+ * @param node_coverage gives the `PerBaseCoverage` of the ith node.
+ */
+template <typename NodeCoverage>
+void write_archive(std::string const &fpath, AlleleSumCoverage const &sums,
+                   SitesGroupedAlleleCounts const &grouped_counts,
+                   uint64_t num_nodes, NodeCoverage node_coverage,
+                   ReadStats const &readstats) {
+  std::ofstream ofs{fpath, std::ios::binary};
+  if (!ofs) throw std::runtime_error("Could not write to " + fpath);
+  boost::archive::binary_oarchive oa{ofs};
+
+  uint64_t const num_sites = sums.size();
+  oa << coverage_checkpoint_version << num_sites << num_nodes;
+  oa << sums << grouped_counts;
+  for (uint64_t i = 0; i < num_nodes; ++i) oa << node_coverage(i);
+  oa << readstats;
+}
+
+struct archive_header {
+  uint64_t num_sites;
+  uint64_t num_nodes;
+};
+
+archive_header read_header(boost::archive::binary_iarchive &ia,
+                           std::string const &fpath) {
+  uint32_t version;
+  archive_header header;
+  ia >> version >> header.num_sites >> header.num_nodes;
+  if (version != coverage_checkpoint_version)
+    throw IncompatibleCheckpoint("Checkpoint " + fpath + " has version " +
+                                 std::to_string(version) + ", expected " +
+                                 std::to_string(coverage_checkpoint_version));
+  return header;
+}
+
+void add_saturating(std::vector<CovCount> &target,
+                    std::vector<CovCount> const &source) {
+  if (target.size() != source.size())
+    throw IncompatibleCheckpoint(
+        "Checkpoints to merge were not made from the same PRG");
+  for (std::size_t i = 0; i < target.size(); ++i)
+    target[i] = saturating_add(target[i], source[i]);
+}
+}  // namespace
+
+void CoverageCheckpoint::merge(CoverageCheckpoint const &other) {
+  if (allele_sum_coverage.size() != other.allele_sum_coverage.size() ||
+      grouped_allele_counts.size() != other.grouped_allele_counts.size() ||
+      node_coverages.size() != other.node_coverages.size())
+    throw IncompatibleCheckpoint(
+        "Checkpoints to merge were not made from the same PRG");
+
+  for (std::size_t i = 0; i < allele_sum_coverage.size(); ++i)
+    add_saturating(allele_sum_coverage[i], other.allele_sum_coverage[i]);
+
+  for (std::size_t i = 0; i < grouped_allele_counts.size(); ++i) {
+    auto &site_counts = grouped_allele_counts[i];
+    for (auto const &entry : other.grouped_allele_counts[i]) {
+      auto &count = site_counts[entry.first];
+      count = saturating_add(count, entry.second);
+    }
+  }
+
+  for (std::size_t i = 0; i < node_coverages.size(); ++i)
+    add_saturating(node_coverages[i], other.node_coverages[i]);
+
+  read_stats.combine(other.read_stats);
+}
+
+CoverageCheckpoint gram::read_checkpoint(std::string const &fpath) {
+  std::ifstream ifs{fpath, std::ios::binary};
+  if (!ifs) throw std::runtime_error("Could not read " + fpath);
+  boost::archive::binary_iarchive ia{ifs};
+  auto header = read_header(ia, fpath);
+
+  CoverageCheckpoint result;
+  ia >> result.allele_sum_coverage >> result.grouped_allele_counts;
+  result.node_coverages.resize(header.num_nodes);
+  for (auto &node_coverage : result.node_coverages) ia >> node_coverage;
+  ia >> result.read_stats;
+  return result;
+}
+
+void gram::write_checkpoint(std::string const &fpath,
+                            CoverageCheckpoint const &checkpoint) {
+  write_archive(
+      fpath, checkpoint.allele_sum_coverage, checkpoint.grouped_allele_counts,
+      checkpoint.node_coverages.size(),
+      [&](uint64_t i) -> PerBaseCoverage const & {
+        return checkpoint.node_coverages[i];
+      },
+      checkpoint.read_stats);
+}
+
+void coverage::dump::checkpoint(std::string const &fpath,
+                                Coverage const &coverage,
+                                coverage_Graph const &cov_graph,
+                                ReadStats const &readstats) {
+  auto const nodes = coverage_nodes(cov_graph);
+  write_archive(
+      fpath, coverage.allele_sum_coverage, coverage.grouped_allele_counts,
+      nodes.size(),
+      [&](uint64_t i) -> PerBaseCoverage const & {
+        return nodes[i]->get_coverage();
+      },
+      readstats);
+}
+
+Coverage coverage::load::checkpoint(std::string const &fpath,
+                                    PRG_Info const &prg_info,
+                                    ReadStats &readstats) {
+  std::ifstream ifs{fpath, std::ios::binary};
+  if (!ifs) throw std::runtime_error("Could not read " + fpath);
+  boost::archive::binary_iarchive ia{ifs};
+  auto header = read_header(ia, fpath);
+
+  auto const &cov_graph = prg_info.coverage_graph;
+  auto const nodes = coverage_nodes(cov_graph);
+  if (header.num_sites != cov_graph.bubble_map.size() ||
+      header.num_nodes != nodes.size())
+    throw IncompatibleCheckpoint("Checkpoint " + fpath +
+                                 " was not made from this PRG");
+
+  Coverage coverage;
+  ia >> coverage.allele_sum_coverage;
+  ia >> coverage.grouped_allele_counts;
+  for (auto const &node : nodes) {
+    ia >> node->get_ref_to_coverage();
+    if (node->get_coverage().size() != node->get_sequence_size())
+      throw IncompatibleCheckpoint("Checkpoint " + fpath +
+                                   " was not made from this PRG");
+  }
+  ia >> readstats;
+  readstats.compute_coverage_depth(coverage, cov_graph);
+
+  coverage.allele_base_coverage =
+      coverage::generate::allele_base_non_nested(prg_info);
+  return coverage;
+}
@@ -82,6 +82,27 @@ void LocusFinder::assign_traversed_loci(SearchState const &search_state,
   }
 }
 
+level0_Sites gram::get_base_sites(SearchState const &search_state,
+                                  info_ptr prg_info) {
+  level0_Sites base_sites;
+  auto const &par_map = prg_info->coverage_graph.par_map;
+  auto add_base_site = [&](Marker site) {
+    while (true) {
+      auto parent = par_map.find(site);
+      if (parent == par_map.end()) break;
+      site = parent->second.first;
+    }
+    base_sites.insert(site);
+  };
+
+  for (auto const &locus : search_state.traversed_path)
+    add_base_site(locus.first);
+  // As in `LocusFinder::assign_traversing_loci`
+  if (not search_state.traversing_path.empty())
+    add_base_site(search_state.traversing_path.rbegin()->first);
+  return base_sites;
+}
+
 MappingInstanceSelector::MappingInstanceSelector(
     SearchStates const search_states, info_ptr prg_info,
     rand_ptr rand_generator)
@@ -89,7 +110,7 @@ MappingInstanceSelector::MappingInstanceSelector(
       usps(),
       prg_info(prg_info),
       rand_generator(rand_generator) {
-  process_searchstates(input_search_states);
+  partition_searchstates(input_search_states);
   int32_t selected_index = random_select_entry();
   if (selected_index >= 0) apply_selection(selected_index);
 }
@@ -109,7 +130,12 @@ int32_t MappingInstanceSelector::random_select_entry() {
 void MappingInstanceSelector::apply_selection(int32_t selected_index) {
   auto it = usps.begin();
   std::advance(it, selected_index);
-  auto chosen_traversal = it->second;
+  auto &chosen_traversal = it->second;
+  // Loci are only resolved for the selected equivalence class
+  for (auto const &ss : chosen_traversal.first) {
+    LocusFinder l{ss, prg_info};
+    for (auto &locus : l.unique_loci) chosen_traversal.second.insert(locus);
+  }
   selected = SelectedMapping{chosen_traversal.first, chosen_traversal.second};
 }
 
@@ -132,6 +158,13 @@ void MappingInstanceSelector::process_searchstates(SearchStates const &all_ss) {
   }
 }
 
+void MappingInstanceSelector::partition_searchstates(
+    SearchStates const &all_ss) {
+  for (auto const &ss : all_ss) {
+    if (ss.has_path()) usps[get_base_sites(ss, prg_info)].first.push_back(ss);
+  }
+}
+
 uint32_t MappingInstanceSelector::count_nonvar_search_states(
     SearchStates const &search_states) {
   uint32_t count = 0;
@@ -166,7 +199,8 @@ uint32_t MappingInstanceSelector::count_nonvar_search_states(
 SelectedMapping selection(const SearchStates &search_states,
                           const uint64_t &read_length, const PRG_Info &prg_info,
                           SeedSize const &selection_seed) {
-  RandomInclusiveInt selector{Seed{selection_seed}};
+  // Cheap to construct, unlike a Mersenne twister: one is made per read
+  CounterRandomInt selector{selection_seed};
   MappingInstanceSelector m{search_states, &prg_info, &selector};
 
   // This contains empty containers if we selected a mapping instance in an
@@ -1,7 +1,8 @@
-#include <fstream>
+#include <algorithm>
 #include <vector>
 
 #include "genotype/quasimap/coverage/grouped_allele_counts.hpp"
+#include "common/file_write.hpp"
 
 using namespace gram;
 
@@ -20,7 +21,7 @@ void coverage::record::grouped_allele_counts(
   // across
   // **all** (selected, ie site-equivalent) mapping instances of the processed
   // read.
-  std::unordered_map<Marker, AlleleIdSet> site_allele_group;
+  std::unordered_map<Marker, AlleleGroup> site_allele_group;
 
   // Loop through all loci and record the alleles compatible with each site
   for (const auto &locus : compatible_loci) {
@@ -32,10 +33,7 @@ void coverage::record::grouped_allele_counts(
   // Loop through the variant site markers traversed at least once by the read.
   for (const auto &entry : site_allele_group) {
     auto site_marker = entry.first;
-    auto allele_ids_set = entry.second;
-    AlleleIds allele_ids;
-    std::copy(allele_ids_set.begin(), allele_ids_set.end(),
-              std::back_inserter(allele_ids));
+    auto const &allele_group = entry.second;
 
     auto site_index = siteID_to_index(site_marker);
 
@@ -44,7 +42,7 @@ void coverage::record::grouped_allele_counts(
 #pragma omp critical
     // Note: if the key does not already exists, creates a key value pair
     // **and** initialises the value to 0.
-    site_coverage[allele_ids] += 1;
+    site_coverage[allele_group] += 1;
   }
 }
 
@@ -55,12 +53,10 @@ AlleleGroupHash gram::hash_allele_groups(
   // Loop through all allele id groups across all variant sites.
   for (const auto &site : sites) {
     for (const auto &allele_group : site) {
-      auto allele_ids_group = allele_group.first;
-      auto group_seen = allele_ids_groups_hash.find(allele_ids_group) !=
-                        allele_ids_groups_hash.end();
-      // Group already has an ID, continue.
-      if (group_seen) continue;
-      allele_ids_groups_hash[allele_ids_group] = group_ID++;
+      // Group already has an ID: not re-inserted.
+      auto inserted =
+          allele_ids_groups_hash.emplace(allele_group.first, group_ID).second;
+      if (inserted) ++group_ID;
     }
   }
   return allele_ids_groups_hash;
@@ -86,7 +82,7 @@ GroupIDToAlleles gram::get_group_id_alleles(
     AlleleGroupHash const &allele_ids_group_hash) {
   GroupIDToAlleles result;
   for (auto const &entry : allele_ids_group_hash)
-    result[std::to_string(entry.second)] = entry.first;
+    result[std::to_string(entry.second)] = entry.first.to_ids();
   return result;
 }
 
@@ -100,12 +96,59 @@ JSON gram::get_json(const SitesGroupedAlleleCounts &sites,
   return result;
 }
 
+void gram::write_grouped_allele_counts(
+    std::ostream &out, SitesGroupedAlleleCounts const &sites,
+    AlleleGroupHash const &allele_ids_groups_hash) {
+  // Group IDs are allocated from 0 and increase by one
+  std::vector<AlleleGroup const *> groups(allele_ids_groups_hash.size());
+  for (auto const &entry : allele_ids_groups_hash)
+    groups.at(entry.second) = &entry.first;
+
+  out << R"({"grouped_allele_counts":{"allele_groups":{)";
+  for (std::size_t group_id = 0; group_id < groups.size(); ++group_id) {
+    if (group_id > 0) out << ",";
+    out << '"' << group_id << R"(":[)";
+    bool first{true};
+    for (auto allele_id : *groups[group_id]) {
+      if (!first) out << ",";
+      out << allele_id;
+      first = false;
+    }
+    out << "]";
+  }
+
+  out << R"(},"site_counts":[)";
+  std::vector<std::pair<uint64_t, CovCount>> site_counts;
+  bool first_site{true};
+  for (auto const &site : sites) {
+    if (!first_site) out << ",";
+    first_site = false;
+
+    site_counts.clear();
+    for (auto const &entry : site)
+      site_counts.emplace_back(allele_ids_groups_hash.at(entry.first),
+                               entry.second);
+    std::sort(site_counts.begin(), site_counts.end());
+
+    out << "{";
+    bool first_group{true};
+    for (auto const &group_count : site_counts) {
+      if (!first_group) out << ",";
+      out << '"' << group_count.first << R"(":)" << group_count.second;
+      first_group = false;
+    }
+    out << "}";
+  }
+  out << "]}}";
+}
+
 void coverage::dump::grouped_allele_counts(const Coverage &coverage,
                                            const GenotypeParams &parameters) {
   auto allele_ids_groups_hash =
       hash_allele_groups(coverage.grouped_allele_counts);
-  auto json = get_json(coverage.grouped_allele_counts, allele_ids_groups_hash);
-  std::ofstream file;
-  file.open(parameters.grouped_allele_counts_fpath);
-  file << json << std::endl;
-}
\ No newline at end of file
+  OutputFile file{parameters.grouped_allele_counts_fpath,
+                  parameters.gzip_coverage};
+  write_grouped_allele_counts(file.stream(), coverage.grouped_allele_counts,
+                              allele_ids_groups_hash);
+  file.stream() << std::endl;
+}
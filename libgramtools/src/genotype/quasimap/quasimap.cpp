@@ -2,6 +2,7 @@
 
 #include <omp.h>
 
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
 
@@ -24,23 +25,26 @@ QuasimapReadsStats gram::quasimap_reads(const GenotypeParams &parameters,
   quasimap_stats.coverage = coverage::generate::empty_structure(prg_info);
   std::cout << "Done generating allele quasimap data structure" << std::endl;
 
-  // Produces seeds to initialise other random number generators used
-  // in multi-mapping read selection
-  auto master_seed_generator = RandomInclusiveInt(parameters.seed);
+  // Each read's seed for multi-mapping read selection is derived from the
+  // master seed and the read's index
+  auto const master_seed =
+      RandomInclusiveInt(parameters.seed).get_seed().value();
 
   std::cout << "Master random seed for read selection: "
-            << std::to_string(master_seed_generator.get_seed().value())
-            << std::endl;
+            << std::to_string(master_seed) << std::endl;
   std::cout << "Maximum thread count: " << parameters.maximum_threads
             << std::endl;
 
   std::cout << "Processing reads:" << std::endl;
 
+  // Shared across read files: duplicate reads can occur in different files
+  MappedReadsCache mapped_reads_cache;
   // Execute quasimap for each read file provided
   for (const auto &reads_fpath : parameters.reads_fpaths) {
     handle_read_file(quasimap_stats, reads_fpath, parameters, kmer_index,
-                     prg_info, &master_seed_generator);
+                     prg_info, master_seed, mapped_reads_cache, readstats);
   }
+  readstats.finalise_base_error_rate();
 
   auto &coverage = quasimap_stats.coverage;
   // Compute read mapping statistics (used in `infer` command). Can only be done
@@ -61,13 +65,17 @@ QuasimapReadsStats gram::quasimap_reads(const GenotypeParams &parameters,
  * Returns a vector of `Pattern`s: a `Pattern` being a vector of `Base`s, which
  * are integer encoded. The encoding of DNA letters to integers also performed
  * in this function.
+ * Reads are also sampled into `readstats`, so that read files only get decoded
+ * once.
  */
 std::vector<Sequence> get_reads_buffer(SeqRead::SeqIterator &reads_it,
                                        SeqRead &reads,
-                                       const uint64_t &max_set_size) {
+                                       const uint64_t &max_set_size,
+                                       ReadStats &readstats) {
   std::vector<Sequence> reads_buffer;
   while (reads_it != reads.end() and reads_buffer.size() < max_set_size) {
     const auto *const raw_read = *reads_it;
+    if (readstats.needs_more_reads()) readstats.record_read(*raw_read);
     auto read = encode_dna_bases(*raw_read);
     reads_buffer.emplace_back(read);
     ++reads_it;
@@ -75,22 +83,71 @@ std::vector<Sequence> get_reads_buffer(SeqRead::SeqIterator &reads_it,
   return reads_buffer;
 }
 
+std::vector<ForwardReverseMapping const *> gram::map_distinct_reads(
+    std::vector<Sequence> const &reads_buffer,
+    MappedReadsCache &mapped_reads_cache, const GenotypeParams &parameters,
+    const KmerIndex &kmer_index, const PRG_Info &prg_info) {
+  std::vector<ForwardReverseMapping const *> read_mappings(
+      reads_buffer.size(), nullptr);
+  // Elements of an unordered_map do not move on insertion, so these pointers
+  // stay valid while the buffer is processed
+  std::vector<MappedReadsCache::value_type *> to_map;
+
+  for (std::size_t i = 0; i < reads_buffer.size(); ++i) {
+    auto const &read = reads_buffer[i];
+    if (read.empty()) continue;
+    auto [entry, inserted] = mapped_reads_cache.try_emplace(read);
+    if (inserted) to_map.push_back(&(*entry));
+    read_mappings[i] = &entry->second;
+  }
+
+  // Reads are mapped in batches, searched in lockstep
+  auto const num_batches =
+      (to_map.size() + search_batch_size - 1) / search_batch_size;
+#pragma omp parallel for schedule(dynamic)
+  for (std::size_t batch = 0; batch < num_batches; ++batch) {
+    auto const first = batch * search_batch_size;
+    auto const last = std::min(first + search_batch_size, to_map.size());
+    Sequences batch_reads;
+    batch_reads.reserve(2 * (last - first));
+    for (auto i = first; i < last; ++i) {
+      batch_reads.push_back(to_map[i]->first);
+      batch_reads.push_back(reverse_complement_read(to_map[i]->first));
+    }
+    auto batch_mappings =
+        map_reads(batch_reads, kmer_index, prg_info, parameters);
+    for (auto i = first; i < last; ++i) {
+      auto &mapping = to_map[i]->second;
+      mapping.forward = std::move(batch_mappings[2 * (i - first)]);
+      mapping.reverse = std::move(batch_mappings[2 * (i - first) + 1]);
+    }
+  }
+  return read_mappings;
+}
+
 /**
- * Calls the (forward_reverse) mapping routine for each read in the read buffer,
- * in parallel (if the CL option has been specified).
+ * Maps each distinct read in the read buffer once, then records coverage for
+ * each read (forward and reverse), in parallel (if the CL option has been
+ * specified). Each copy of a duplicated read uses its own selection seed, so
+ * results are the same as mapping every copy.
+ * @param first_read_index the index of the first read of the buffer among all
+ * reads processed.
  */
 void handle_reads_buffer(QuasimapReadsStats &quasimap_stats,
                          const std::vector<Sequence> &reads_buffer,
-                         Seeds const &selection_seeds,
+                         SeedSize const &master_seed,
+                         uint64_t const &first_read_index,
                          const GenotypeParams &parameters,
-                         const KmerIndex &kmer_index,
-                         const PRG_Info &prg_info) {
+                         const KmerIndex &kmer_index, const PRG_Info &prg_info,
+                         MappedReadsCache &mapped_reads_cache) {
   uint64_t last_count_reported = 0;
+  auto const read_mappings = map_distinct_reads(
+      reads_buffer, mapped_reads_cache, parameters, kmer_index, prg_info);
 
 #pragma omp parallel for
   for (std::size_t i = 0; i < reads_buffer.size(); ++i) {
     auto thread_id = omp_get_thread_num();
-    //  Report total number of mapped reads everytime at least `diff` such have
+    //  Report total number of mapped reads everytime at least `diff` such have
     //  been mapped
     if (thread_id == 0) {
       uint64_t diff = quasimap_stats.all_reads_count - last_count_reported;
@@ -105,15 +162,20 @@ void handle_reads_buffer(QuasimapReadsStats &quasimap_stats,
     quasimap_stats.all_reads_count +=
         2;  //  Increment by 2: mapping forward and reverse of read
 
-    auto const read = reads_buffer.at(i);
-    if (read.empty()) {
+    auto const *read_mapping = read_mappings.at(i);
+    if (read_mapping == nullptr) {
 #pragma omp atomic
       quasimap_stats.skipped_reads_count += 2;
       continue;
     }
-    auto const selection_seed = selection_seeds.at(i);
-    quasimap_forward_reverse(quasimap_stats, read, parameters, kmer_index,
-                             prg_info, selection_seed);
+    auto const selection_seed = derive_seed(master_seed, first_read_index + i);
+    auto const read_length = reads_buffer[i].size();
+    record_read_mapping(read_mapping->forward, read_length,
+                        quasimap_stats.coverage, quasimap_stats, prg_info,
+                        selection_seed);
+    record_read_mapping(read_mapping->reverse, read_length,
+                        quasimap_stats.coverage, quasimap_stats, prg_info,
+                        selection_seed);
   }
 }
 
@@ -122,21 +184,27 @@ void gram::handle_read_file(QuasimapReadsStats &quasimap_stats,
                             const GenotypeParams &parameters,
                             const KmerIndex &kmer_index,
                             const PRG_Info &prg_info,
-                            RandomGenerator *const seed_generator) {
+                            SeedSize const &master_seed,
+                            MappedReadsCache &mapped_reads_cache,
+                            ReadStats &readstats) {
   //  Number of reads to load in memory; is upper limit of number of reads that
   //  can be mapped in parallel
   uint64_t max_num_reads = 5000;
-  // Used for random selection of multi-mapping reads
-  Seeds selection_seeds(max_num_reads);
+  //  Bounds the memory used by the cache of mapped reads: when reads are mostly
+  //  distinct, the cache is regularly emptied
+  uint64_t max_cached_reads = 20 * max_num_reads;
 
   SeqRead reads(reads_fpath.c_str());
   auto reads_it = reads.begin();
   while (reads_it != reads.end()) {
-    auto reads_buffer = get_reads_buffer(reads_it, reads, max_num_reads);
-    for (int i = 0; i < max_num_reads; i++)
-      selection_seeds.at(i) = (*seed_generator)();
-    handle_reads_buffer(quasimap_stats, reads_buffer, selection_seeds,
-                        parameters, kmer_index, prg_info);
+    auto reads_buffer = get_reads_buffer(reads_it, reads, max_num_reads, readstats);
+    // Two counts per read so far, forward and reverse, across all read files
+    uint64_t const first_read_index = quasimap_stats.all_reads_count / 2;
+    if (mapped_reads_cache.size() + reads_buffer.size() > max_cached_reads)
+      mapped_reads_cache.clear();
+    handle_reads_buffer(quasimap_stats, reads_buffer, master_seed,
+                        first_read_index, parameters, kmer_index, prg_info,
+                        mapped_reads_cache);
   }
 }
 
@@ -161,36 +229,107 @@ void gram::quasimap_read(const Sequence &read, Coverage &coverage,
                          const GenotypeParams &parameters,
                          QuasimapReadsStats &stats,
                          SeedSize const &selection_seed) {
-  /*
-   * We can discard reads containing 1 or more kmers not present in the index.
-   * This is based on the following assumptions:
-   *   - All kmers of size `kmers_size` in the PRG are in the index
-   *   - Reads must be mapped exactly
-   */
-  bool read_can_map_exactly =
-      all_read_kmers_occur_in_index(parameters.kmers_size, read, kmer_index);
-  if (not read_can_map_exactly) {
-#pragma omp atomic
-    stats.missing_kmer_reads_count += 1;
-    return;
+  auto const read_mapping = map_read(read, kmer_index, prg_info, parameters);
+  record_read_mapping(read_mapping, read.size(), coverage, stats, prg_info,
+                      selection_seed);
+}
+
+ReadMapping gram::map_read(const Sequence &read, const KmerIndex &kmer_index,
+                           const PRG_Info &prg_info,
+                           const GenotypeParams &parameters) {
+  return map_reads(Sequences{read}, kmer_index, prg_info, parameters).front();
+}
+
+std::vector<ReadMapping> gram::map_reads(const Sequences &reads,
+                                         const KmerIndex &kmer_index,
+                                         const PRG_Info &prg_info,
+                                         const GenotypeParams &parameters) {
+  std::vector<ReadMapping> read_mappings(reads.size());
+  Sequences searched_reads;
+  std::vector<std::size_t> searched_indices;
+  for (std::size_t i = 0; i < reads.size(); ++i) {
+    /*
+     * We can discard reads containing 1 or more kmers not present in the
+     * index. This is based on the following assumptions:
+     *   - All kmers of size `kmers_size` in the PRG are in the index
+     *   - Reads must be mapped exactly
+     */
+    if (not all_read_kmers_occur_in_index(parameters.kmers_size, reads[i],
+                                          kmer_index))
+      continue;
+    searched_reads.push_back(reads[i]);
+    searched_indices.push_back(i);
   }
 
-  auto seeding_kmer = get_last_kmer_in_read(parameters.kmers_size, read);
-  auto search_states =
-      search_read_backwards(read, seeding_kmer, kmer_index, prg_info);
-  // Test read did not map
-  if (search_states.empty()) {
-#pragma omp atomic
-    stats.no_extension_reads_count += 1;
-    return;
+  auto all_search_states = extend_reads_backwards(
+      searched_reads, parameters.kmers_size, kmer_index, prg_info);
+  auto const &max_occurrences = parameters.max_read_occurrences;
+  for (std::size_t j = 0; j < searched_indices.size(); ++j) {
+    auto &read_mapping = read_mappings[searched_indices[j]];
+    auto &search_states = all_search_states[j];
+    if (search_states.empty()) {
+      read_mapping.status = MappingStatus::no_extension;
+      continue;
+    }
+
+    // Capping is done before handling allele-encapsulated search states,
+    // which requires a suffix array lookup per occurrence
+    bool repetitive = max_occurrences > 0 and
+                      count_occurrences(search_states) > max_occurrences;
+    if (repetitive) {
+      if (parameters.repetitive_reads_policy == RepetitiveReadsPolicy::Skip) {
+        read_mapping.status = MappingStatus::repetitive;
+        continue;
+      }
+      search_states = downsample_occurrences(search_states, max_occurrences);
+      read_mapping.downsampled = true;
+    }
+    read_mapping.status = MappingStatus::mapped;
+    read_mapping.search_states =
+        handle_allele_encapsulated_states(search_states, prg_info);
   }
+  return read_mappings;
+}
+
+ForwardReverseMapping gram::map_forward_reverse(
+    const Sequence &read, const KmerIndex &kmer_index,
+    const PRG_Info &prg_info, const GenotypeParams &parameters) {
+  ForwardReverseMapping result;
+  result.forward = map_read(read, kmer_index, prg_info, parameters);
+  auto reverse_read = reverse_complement_read(read);
+  result.reverse = map_read(reverse_read, kmer_index, prg_info, parameters);
+  return result;
+}
 
-  auto read_length = read.size();
-  coverage::record::search_states(coverage, search_states, read_length,
-                                  prg_info, selection_seed);
+void gram::record_read_mapping(const ReadMapping &read_mapping,
+                               const uint64_t &read_length, Coverage &coverage,
+                               QuasimapReadsStats &stats,
+                               const PRG_Info &prg_info,
+                               SeedSize const &selection_seed) {
+  switch (read_mapping.status) {
+    case MappingStatus::missing_kmer:
+#pragma omp atomic
+      stats.missing_kmer_reads_count += 1;
+      return;
+    case MappingStatus::no_extension:
+#pragma omp atomic
+      stats.no_extension_reads_count += 1;
+      return;
+    case MappingStatus::repetitive:
+#pragma omp atomic
+      stats.repetitive_reads_count += 1;
+      return;
+    case MappingStatus::mapped:
+      if (read_mapping.downsampled) {
+#pragma omp atomic
+        stats.repetitive_reads_count += 1;
+      }
+      coverage::record::search_states(coverage, read_mapping.search_states,
+                                      read_length, prg_info, selection_seed);
 #pragma omp atomic
-  stats.exact_mapped_reads_count += 1;
-  return;
+      stats.exact_mapped_reads_count += 1;
+      return;
+  }
 }
 
 Sequence gram::get_kmer_in_read(const uint32_t &kmer_size,
@@ -255,6 +394,101 @@ SearchStates gram::search_read_backwards(const Sequence &read,
   return new_search_states;
 }
 
+std::vector<SearchStates> gram::extend_reads_backwards(
+    const Sequences &reads, const uint32_t &kmer_size,
+    const KmerIndex &kmer_index, const PRG_Info &prg_info) {
+  std::vector<SearchStates> all_search_states(reads.size());
+  // Reads still being extended, and the number of bases left to extend them by
+  std::vector<std::size_t> active;
+  std::vector<std::size_t> bases_left(reads.size(), 0);
+
+  for (std::size_t i = 0; i < reads.size(); ++i) {
+    auto const kmer = get_last_kmer_in_read(kmer_size, reads[i]);
+    auto const found = kmer_index.find(kmer);
+    if (found == kmer_index.end()) continue;
+    all_search_states[i] = found->second;
+    bases_left[i] = reads[i].size() - kmer_size;
+    if (bases_left[i] > 0) active.push_back(i);
+  }
+
+  std::vector<std::size_t> still_active;
+  while (not active.empty()) {
+    // First pass: vBWT jumps, and prefetches for the next base extension
+    for (auto const i : active) {
+      auto &search_states = all_search_states[i];
+      process_markers_search_states(search_states, prg_info);
+      auto const &pattern_char = reads[i][bases_left[i] - 1];
+      for (auto const &search_state : search_states)
+        prefetch_next_sa_interval(pattern_char, search_state.sa_interval,
+                                  prg_info);
+    }
+
+    // Second pass: the base extensions proper
+    still_active.clear();
+    for (auto const i : active) {
+      auto &search_states = all_search_states[i];
+      auto const &pattern_char = reads[i][--bases_left[i]];
+      search_states =
+          search_base_backwards(pattern_char, search_states, prg_info);
+      if (not search_states.empty() and bases_left[i] > 0)
+        still_active.push_back(i);
+    }
+    std::swap(active, still_active);
+  }
+
+  return all_search_states;
+}
+
+std::vector<SearchStates> gram::search_reads_backwards(
+    const Sequences &reads, const uint32_t &kmer_size,
+    const KmerIndex &kmer_index, const PRG_Info &prg_info) {
+  auto all_search_states =
+      extend_reads_backwards(reads, kmer_size, kmer_index, prg_info);
+  for (auto &search_states : all_search_states)
+    search_states = handle_allele_encapsulated_states(search_states, prg_info);
+  return all_search_states;
+}
+
+uint64_t gram::count_occurrences(SearchStates const &search_states) {
+  uint64_t count = 0;
+  for (auto const &search_state : search_states)
+    count += search_state.sa_interval.second - search_state.sa_interval.first +
+             1;
+  return count;
+}
+
+SearchStates gram::downsample_occurrences(SearchStates const &search_states,
+                                          uint64_t const &max_occurrences) {
+  auto const total = count_occurrences(search_states);
+  if (total <= max_occurrences) return search_states;
+
+  SearchStates kept;
+  // Occurrences are numbered across all search states, in order; the kept
+  // ones are at indices floor(j * total / max_occurrences)
+  uint64_t j = 0, offset = 0;
+  for (auto const &search_state : search_states) {
+    auto const size =
+        search_state.sa_interval.second - search_state.sa_interval.first + 1;
+    bool extending = false;
+    for (; j < max_occurrences; ++j) {
+      auto const kept_index = j * total / max_occurrences;
+      if (kept_index >= offset + size) break;
+      SA_Index sa_index = search_state.sa_interval.first + kept_index - offset;
+      // Adjacent kept occurrences are grouped in a single SA interval
+      if (extending and kept.back().sa_interval.second + 1 == sa_index) {
+        kept.back().sa_interval.second = sa_index;
+        continue;
+      }
+      auto new_search_state = search_state;
+      new_search_state.sa_interval = SA_Interval{sa_index, sa_index};
+      kept.push_back(new_search_state);
+      extending = true;
+    }
+    offset += size;
+  }
+  return kept;
+}
+
 SearchStates gram::process_read_char_search_states(const int_Base &pattern_char,
                                                    SearchStates &search_states,
                                                    const PRG_Info &prg_info) {
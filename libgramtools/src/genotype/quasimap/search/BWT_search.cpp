@@ -21,6 +21,39 @@ uint64_t gram::dna_bwt_rank(const uint64_t &upper_index, const Marker &dna_base,
   }
 }
 
+void gram::prefetch_dna_bwt_rank(const uint64_t &upper_index,
+                                 const Marker &dna_base,
+                                 const PRG_Info &prg_info) {
+  sdsl::bit_vector const *mask;
+  switch (dna_base) {
+    case 1:
+      mask = &prg_info.dna_bwt_masks.mask_a;
+      break;
+    case 2:
+      mask = &prg_info.dna_bwt_masks.mask_c;
+      break;
+    case 3:
+      mask = &prg_info.dna_bwt_masks.mask_g;
+      break;
+    case 4:
+      mask = &prg_info.dna_bwt_masks.mask_t;
+      break;
+    default:
+      return;
+  }
+  if (upper_index >= mask->size()) return;
+  // Each 64-bit word of the mask holds 64 bwt positions
+  __builtin_prefetch(mask->data() + (upper_index >> 6));
+}
+
+void gram::prefetch_next_sa_interval(const Marker &next_char,
+                                     const SA_Interval &current_sa_interval,
+                                     const PRG_Info &prg_info) {
+  if (current_sa_interval.first > 0)
+    prefetch_dna_bwt_rank(current_sa_interval.first, next_char, prg_info);
+  prefetch_dna_bwt_rank(current_sa_interval.second + 1, next_char, prg_info);
+}
+
 /**
  * Backward search followed by check whether the extended searched pattern maps
  * somewhere in the prg.
@@ -20,52 +20,41 @@ void gram::ReadStats::compute_base_error_rate(GenomicRead_vector const& reads) {
 
 void gram::ReadStats::process_read_perbase_error_rates(
     AbstractGenomicReadIterator& reads_it) {
-  // The number of reads (with at least one base with recorded quality) to
-  // estimate from. Is defined in the header file.
-  uint64_t required_reads = NUM_READS_USED;
-  uint64_t num_informative_reads = 0;
-
-  int64_t no_qual_reads = 0;
-  int64_t num_bases_processed = 0;
-  double mean_error = 0;
-
-  float running_qual_score = 0.0;
-
-  while (num_informative_reads < required_reads and reads_it.has_more_reads()) {
-    auto* const raw_read = *reads_it;
-
-    // Test for max read length
-    std::string sequence = std::string(raw_read->seq);
-    auto sequence_length = sequence.length();
-    if (sequence_length > this->max_read_length)
-      this->max_read_length = sequence_length;
+  while (needs_more_reads() and reads_it.has_more_reads()) {
+    record_read(**reads_it);
+    ++reads_it;
+  }
+  finalise_base_error_rate();
+}
 
-    // Process quality scores
-    std::string qualities = std::string(raw_read->qual);
+void gram::ReadStats::record_read(GenomicRead const& read) {
+  if (!needs_more_reads()) return;
 
-    if (qualities.length() ==
-        0) {  // We will keep looking for reads with quality scored bases.
-      no_qual_reads++;
-      ++reads_it;
-      continue;
-    }
+  if (read.seq.length() > this->max_read_length)
+    this->max_read_length = read.seq.length();
 
-    for (const auto base : qualities) {
-      running_qual_score += (base - 33);  // Assuming +33 Phred-scoring
-      num_bases_processed++;
-    }
+  // We will keep looking for reads with quality scored bases.
+  if (read.qual.empty()) {
+    num_no_qual_recorded++;
+    return;
+  }
 
-    num_informative_reads++;
-    ++reads_it;
+  for (const auto base : read.qual) {
+    running_qual_score += (base - 33);  // Assuming +33 Phred-scoring
+    num_bases_recorded++;
   }
+  num_informative_reads++;
+}
 
-  if (num_bases_processed > 0) {
-    double mean_qual = running_qual_score / num_bases_processed;
+void gram::ReadStats::finalise_base_error_rate() {
+  double mean_error = 0;
+  if (num_bases_recorded > 0) {
+    double mean_qual = running_qual_score / num_bases_recorded;
     mean_error = pow(10, -mean_qual / 10);
   }
 
-  this->num_bases_processed = num_bases_processed;
-  this->no_qual_reads = no_qual_reads;
+  this->num_bases_processed = num_bases_recorded;
+  this->no_qual_reads = num_no_qual_recorded;
   this->mean_pb_error = mean_error;
 }
 
@@ -159,6 +148,29 @@ void gram::AbstractReadStats::compute_coverage_depth(
   this->num_sites_total = coverages.size();
 }
 
+void gram::ReadStats::combine(ReadStats const& other) {
+  if (other.num_bases_processed > 0) {
+    if (num_bases_processed > 0) {
+      auto total_bases = num_bases_processed + other.num_bases_processed;
+      mean_pb_error = (mean_pb_error * num_bases_processed +
+                       other.mean_pb_error * other.num_bases_processed) /
+                      total_bases;
+      num_bases_processed = total_bases;
+    } else {
+      mean_pb_error = other.mean_pb_error;
+      num_bases_processed = other.num_bases_processed;
+    }
+  }
+  if (other.no_qual_reads > 0)
+    no_qual_reads = std::max(no_qual_reads, int64_t{0}) + other.no_qual_reads;
+  max_read_length = std::max(max_read_length, other.max_read_length);
+
+  mean_cov_depth = -1;
+  variance_cov_depth = -1;
+  num_sites_noCov = 0;
+  num_sites_total = -1;
+}
+
 void gram::ReadStats::serialise(const std::string& json_output_fpath) {
   std::ofstream outf;
   outf.open(json_output_fpath);
@@ -1,39 +1,54 @@
 #include "prg/linearised_prg.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+
 #include "common/parameters.hpp"
 #include "common/utils.hpp"
 
+namespace {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr endianness host_endianness{endianness::big};
+#else
+constexpr endianness host_endianness{endianness::little};
+#endif
+
+/**
+ * Reverses the byte order of each marker. Written branch-free so that the
+ * compiler vectorises it.
+ */
+void swap_bytes(Marker *markers, std::size_t size) {
+  static_assert(sizeof(Marker) == gram::num_bytes_per_integer);
+  for (std::size_t i = 0; i < size; ++i) {
+    auto const m = markers[i];
+    markers[i] = (m >> 24) | ((m >> 8) & 0xff00) | ((m << 8) & 0xff0000) |
+                 (m << 24);
+  }
+}
+}  // namespace
+
 /**********************
  * Supporting nesting**
  **********************/
 PRG_String::PRG_String(std::string const &file_in, endianness en)
     : odd_site_end_found(false), en(en) {
-  std::fstream input(file_in, std::ios::in | std::ios::binary);
-  if (!input)
-    throw std::ios::failure("PRG String file not found");
-  else {
-    uint32_t c{0};
-    uint8_t buffer[gram::num_bytes_per_integer];  // Note, use uint8_t and not
-                                                  // char which is signed
-    size_t byte_pos;
-    while (true) {
-      input.read((char *)&buffer,
-                 gram::num_bytes_per_integer);  // Read byte by byte
-      if (input.eof()) break;
-
-      if (en == endianness::big) {
-        c = (uint32_t)buffer[0] << 24 | (uint32_t)buffer[1] << 16 |
-            (uint32_t)buffer[2] << 8 | (uint32_t)buffer[3];
-      } else {
-        c = (uint32_t)buffer[0] | (uint32_t)buffer[1] << 8 |
-            (uint32_t)buffer[2] << 16 | (uint32_t)buffer[3] << 24;
-      }
+  std::ifstream input(file_in, std::ios::in | std::ios::binary);
+  if (!input) throw std::ios::failure("PRG String file not found");
+
+  // Read the whole file in one go, straight into the marker vector
+  input.seekg(0, std::ios::end);
+  auto const num_bytes = static_cast<std::size_t>(input.tellg());
+  input.seekg(0, std::ios::beg);
+  my_PRG_string.resize(num_bytes / gram::num_bytes_per_integer);
+  input.read(reinterpret_cast<char *>(my_PRG_string.data()),
+             my_PRG_string.size() * gram::num_bytes_per_integer);
+  if (!input) throw std::ios::failure("Could not read PRG String file");
+  if (en != host_endianness)
+    swap_bytes(my_PRG_string.data(), my_PRG_string.size());
+  assert(std::find(my_PRG_string.begin(), my_PRG_string.end(), 0) ==
+         my_PRG_string.end());
 
-      if (input.eof()) break;
-      assert(c >= 1);
-      my_PRG_string.push_back(c);
-      c = 0;
-    }
-  };
   output_file = file_in;
   map_ends_and_check_for_duplicates();
 
@@ -86,29 +101,21 @@ void PRG_String::write(std::string const &fname, endianness en) {
     exit(1);
   }
 
-  std::vector<char> buffer(gram::num_bytes_per_integer);
-  uint8_t byte_number;
-
-  uint8_t model_byte_number;
-  if (en == endianness::big)
-    model_byte_number = gram::num_bytes_per_integer - 1;
-  else
-    model_byte_number = 0;
-
-  for (auto &s : my_PRG_string) {
-    buffer.clear();
-    byte_number = model_byte_number;
-    while (true) {
-      // In big endian, will push the most significant bytes first in buffer
-      // In little ^^,  will push the least ^^         ^^      ^^
-      buffer.push_back(s >> 8 * byte_number);
-      if (en == endianness::big) {
-        if (byte_number-- == 0) break;
-      } else {
-        if (byte_number++ == gram::num_bytes_per_integer - 1) break;
-      }
+  if (en == host_endianness) {
+    out.write(reinterpret_cast<char const *>(my_PRG_string.data()),
+              my_PRG_string.size() * gram::num_bytes_per_integer);
+  } else {
+    // Byte-swap one block at a time rather than copying the whole vector
+    marker_vec block;
+    for (std::size_t start = 0; start < my_PRG_string.size();
+         start += PRG_STRING_IO_BLOCK_SIZE) {
+      auto const end =
+          std::min(start + PRG_STRING_IO_BLOCK_SIZE, my_PRG_string.size());
+      block.assign(my_PRG_string.begin() + start, my_PRG_string.begin() + end);
+      swap_bytes(block.data(), block.size());
+      out.write(reinterpret_cast<char const *>(block.data()),
+                block.size() * gram::num_bytes_per_integer);
     }
-    for (auto e : buffer) out.write(&e, 1);
   }
   out.close();
 }
@@ -201,7 +208,7 @@ marker_vec gram::prg_string_to_ints(std::string const &string_prg) {
                     << " is not a nucleotide char";
           exit(1);
         }
-        encoded_prg[char_count++] = encode_dna_base(c);
+        encoded_prg[char_count++] = base;
         break;
       }
     }
@@ -216,49 +223,74 @@ marker_vec gram::prg_string_to_ints(std::string const &string_prg) {
  * Not Supporting nesting**
  **************************/
 
+namespace {
 /**
- * Converts a sequence of digits (0-9) into a single integer.
- */
-uint64_t concat_marker_digits(const std::vector<int> &marker_digits) {
-  uint64_t marker = 0;
-  for (const auto &digit : marker_digits) marker = marker * 10 + digit;
-  return marker;
-}
-
-/**
- * Write out marker digits to the encoded prg as a single integer.
- * @see concat_marker_digits()
+ * Encodes `prg_raw[begin..end)` into `out`, which needs room for
+ * `end - begin` markers. The range must not split a variant marker.
+ * @return the number of markers written
  */
-void flush_marker_digits(std::vector<int> &marker_digits,
-                         marker_vec &encoded_prg, uint64_t &count_chars) {
-  if (marker_digits.empty()) return;
-
-  uint64_t marker = concat_marker_digits(marker_digits);
-  encoded_prg[count_chars++] = marker;
-  marker_digits.clear();
-}
-
-marker_vec gram::encode_prg(const std::string &prg_raw) {
-  marker_vec encoded_prg(prg_raw.length(), 0);
-
-  uint64_t count_chars = 0;
-  // TODO: this should be possible without storing each individual digit
-  std::vector<int> marker_digits;
-  for (const auto &c : prg_raw) {
-    EncodeResult encode_result = encode_char(c);
+std::size_t encode_prg_chunk(const std::string &prg_raw, std::size_t begin,
+                             std::size_t end, Marker *out) {
+  std::size_t count_chars = 0;
+  Marker marker = 0;  // Accumulates the digits of a variant marker
+  bool in_marker = false;
+  for (std::size_t i = begin; i < end; ++i) {
+    EncodeResult encode_result = encode_char(prg_raw[i]);
 
     if (encode_result.is_dna) {
-      // `flush_marker_digits` flushes any latent marker characters
-      flush_marker_digits(marker_digits, encoded_prg, count_chars);
-      encoded_prg[count_chars++] = encode_result.character;
+      // Flush any latent marker characters
+      if (in_marker) out[count_chars++] = marker;
+      marker = 0;
+      in_marker = false;
+      out[count_chars++] = encode_result.character;
       continue;
     }
 
     // else: record the digit, and stand ready to record another
     // TODO: check that character is numeric?
-    marker_digits.push_back(encode_result.character);
+    marker = marker * 10 + encode_result.character;
+    in_marker = true;
+  }
+  if (in_marker) out[count_chars++] = marker;
+  return count_chars;
+}
+}  // namespace
+
+marker_vec gram::encode_prg(const std::string &prg_raw) {
+  marker_vec encoded_prg(prg_raw.length(), 0);
+  auto const num_chunks =
+      prg_raw.size() < ENCODE_PRG_MIN_CHUNK_SIZE
+          ? 1
+          : std::min<std::size_t>(omp_get_max_threads(),
+                                  prg_raw.size() / ENCODE_PRG_MIN_CHUNK_SIZE);
+
+  // Chunk boundaries get moved forward so as not to split a variant marker
+  std::vector<std::size_t> boundaries{0};
+  for (std::size_t c = 1; c < num_chunks; ++c) {
+    auto boundary =
+        std::max(boundaries.back(), prg_raw.size() / num_chunks * c);
+    while (boundary > 0 && boundary < prg_raw.size() &&
+           !encode_char(prg_raw[boundary - 1]).is_dna &&
+           !encode_char(prg_raw[boundary]).is_dna)
+      ++boundary;
+    boundaries.push_back(boundary);
+  }
+  boundaries.push_back(prg_raw.size());
+
+  // Each chunk is encoded in place, then moved down next to the previous one
+  std::vector<std::size_t> chunk_sizes(num_chunks);
+#pragma omp parallel for
+  for (std::size_t c = 0; c < num_chunks; ++c)
+    chunk_sizes[c] = encode_prg_chunk(prg_raw, boundaries[c], boundaries[c + 1],
+                                      encoded_prg.data() + boundaries[c]);
+
+  std::size_t count_chars = chunk_sizes.front();
+  for (std::size_t c = 1; c < num_chunks; ++c) {
+    auto const chunk_start = encoded_prg.begin() + boundaries[c];
+    std::copy(chunk_start, chunk_start + chunk_sizes[c],
+              encoded_prg.begin() + count_chars);
+    count_chars += chunk_sizes[c];
   }
-  flush_marker_digits(marker_digits, encoded_prg, count_chars);
 
   encoded_prg.resize(count_chars);
   return encoded_prg;
@@ -25,31 +25,55 @@ gt_sites gram::simulate::make_nulled_sites(coverage_Graph const& input_prg) {
   return genotyped_records;
 }
 
-void NodeThread::visit(nt_ptr_v& to_visit, std::string const& sequence) const {
-  auto node_size = prg_node->get_sequence_size();
-  if (prg_node->has_sequence()) {
-    auto seq_slice = sequence.substr(offset, node_size);
-    // Only add new nodes to visit if this node's sequence matches
-    if (seq_slice != prg_node->get_sequence()) return;
-  }
-  for (auto const& n : prg_node->get_edges()) {
-    auto new_node = std::make_shared<const NodeThread>(shared_from_this(), n,
-                                                       offset + node_size);
-    to_visit.push_back(new_node);
-  }
-}
+namespace {
+/** A node on the path being explored, and how many of its edges are left */
+struct PathFrame {
+  covG_ptr prg_node;
+  int offset;
+  std::size_t edges_left;
+};
+}  // namespace
 
 nt_ptr_v gram::simulate::thread_sequence(covG_ptr root,
                                          std::string const& sequence) {
-  auto cur_Node = std::make_shared<const NodeThread>(nullptr, root, 0);
-  nt_ptr_v to_visit{cur_Node}, endpoints;
-  while (not to_visit.empty()) {
-    cur_Node = to_visit.back();
-    to_visit.pop_back();
-    if (not cur_Node->has_next())
-      endpoints.push_back(cur_Node);
-    else
-      cur_Node->visit(to_visit, sequence);
+  std::vector<PathFrame> path;
+  // `NodeThread`s of a prefix of `path`, only built when an endpoint is found
+  // and shared between the endpoints it leads to
+  nt_ptr_v threads, endpoints;
+
+  auto const enter = [&](covG_ptr const& prg_node, int const offset) {
+    if (prg_node->get_num_edges() == 0) {
+      for (auto i = threads.size(); i < path.size(); ++i)
+        threads.push_back(std::make_shared<const NodeThread>(
+            i == 0 ? nullptr : threads.back(), path[i].prg_node,
+            path[i].offset));
+      endpoints.push_back(std::make_shared<const NodeThread>(
+          threads.empty() ? nullptr : threads.back(), prg_node, offset));
+      return;
+    }
+    // Only explore further if this node's sequence matches
+    if (prg_node->has_sequence() &&
+        sequence.compare(offset, prg_node->get_sequence_size(),
+                         prg_node->get_sequence()) != 0)
+      return;
+    path.push_back(PathFrame{prg_node, offset, prg_node->get_num_edges()});
+  };
+
+  // Edges get explored last to first, which finds endpoints in the same order
+  // as a stack of nodes to visit does
+  enter(root, 0);
+  while (!path.empty()) {
+    auto& frame = path.back();
+    if (frame.edges_left == 0) {
+      path.pop_back();
+      if (threads.size() > path.size()) threads.pop_back();
+      continue;
+    }
+    --frame.edges_left;
+    auto const next_offset =
+        frame.offset + static_cast<int>(frame.prg_node->get_sequence_size());
+    auto const next_node = frame.prg_node->get_edges()[frame.edges_left];
+    enter(next_node, next_offset);
   }
   return endpoints;
 }
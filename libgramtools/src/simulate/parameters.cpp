@@ -1,4 +1,7 @@
 #include "simulate/parameters.hpp"
+
+#include <omp.h>
+
 #include <iostream>
 
 using namespace gram;
@@ -7,6 +10,7 @@ SimulateParams commands::simulate::parse_parameters(
     po::variables_map &vm, const po::parsed_options &parsed) {
   SimulateParams parameters;
   std::string output_dir_fpath;
+  Seed::value_type seed;
 
   po::options_description simulate_description("simulate options");
   simulate_description.add_options()(
@@ -19,7 +23,12 @@ SimulateParams commands::simulate::parse_parameters(
       "o", po::value<std::string>(&output_dir_fpath)->required(),
       "directory containing outputs")(
       "i", po::value<std::string>(&parameters.input_sequences_fpath),
-      "input sequences to induce genotypes on");
+      "input sequences to induce genotypes on")(
+      "max_threads", po::value<uint32_t>()->default_value(1),
+      "maximum number of threads used")(
+      "seed", po::value<SeedSize>(&seed),
+      "seed for pseudo-random path simulation. "
+      "a random seed is generated if this option is not used.");
 
   std::vector<std::string> opts =
       po::collect_unrecognized(parsed.options, po::include_positional);
@@ -39,5 +48,10 @@ SimulateParams commands::simulate::parse_parameters(
       full_path(output_dir_fpath, parameters.sample_id + std::string(".json"));
   parameters.fasta_out_fpath =
       full_path(output_dir_fpath, parameters.sample_id + std::string(".fasta"));
+
+  parameters.maximum_threads = vm["max_threads"].as<uint32_t>();
+  omp_set_num_threads(parameters.maximum_threads);
+
+  if (vm.count("seed")) parameters.seed = seed;
   return parameters;
 }
@@ -1,9 +1,16 @@
 #include "simulate/simulate.hpp"
 
+#include <omp.h>
+
+#include <unordered_set>
+
+#include <boost/functional/hash.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
 
 #include "common/file_read.hpp"
+#include "common/parallel.hpp"
 #include "genotype/infer/allele_extracter.hpp"
+#include "genotype/infer/output_specs/json_combine.hpp"
 #include "genotype/infer/output_specs/make_json.hpp"
 #include "genotype/infer/output_specs/segment_tracker.hpp"
 #include "genotype/infer/personalised_reference.hpp"
@@ -16,24 +23,56 @@ using namespace gram::simulate;
 
 namespace gram::simulate {
 
-SimulationGenotyper::SimulationGenotyper(coverage_Graph const& cov_graph) {
-  this->cov_graph = &cov_graph;
+SimulationTemplate::SimulationTemplate(coverage_Graph const& cov_graph)
+    : cov_graph(&cov_graph) {
   child_m = build_child_map(
       cov_graph.par_map);  // Required for site invalidation & json output
+  // Sites with no nested sites have the same alleles in all paths
+  gt_sites no_records(cov_graph.bubble_map.size());
+  for (auto const& bubble_pair : cov_graph.bubble_map) {
+    bubbles.push_back(bubble_pair);
+    auto site_ID = bubble_pair.first->get_site_ID();
+    if (child_m.find(site_ID) == child_m.end())
+      fixed_alleles.push_back(
+          AlleleExtracter(bubble_pair.first, bubble_pair.second, no_records)
+              .get_alleles());
+    else
+      fixed_alleles.push_back(std::nullopt);
+
+    if (cov_graph.par_map.find(site_ID) == cov_graph.par_map.end())
+      lvl1_site_indices.push_back(siteID_to_index(site_ID));
+  }
+  std::sort(lvl1_site_indices.begin(), lvl1_site_indices.end());
+}
+
+SimulationGenotyper::SimulationGenotyper(coverage_Graph const& cov_graph)
+    : SimulationGenotyper(
+          SimulationTemplate(cov_graph),
+          std::make_unique<RandomInclusiveInt>(std::nullopt).get()) {}
+
+SimulationGenotyper::SimulationGenotyper(
+    SimulationTemplate const& simu_template, RandomGenerator* const rand) {
+  this->cov_graph = simu_template.cov_graph;
+  child_m = simu_template.child_m;
   genotyped_records.resize(
-      cov_graph.bubble_map
+      simu_template.bubbles
           .size());  // Pre-allocate one slot for each bubble in the PRG
 
   // Genotype each bubble in the PRG, in most nested to less nested order.
-  for (auto const& bubble_pair : cov_graph.bubble_map) {
+  for (std::size_t i = 0; i < simu_template.bubbles.size(); ++i) {
+    auto const& bubble_pair = simu_template.bubbles[i];
     auto site_ID = bubble_pair.first->get_site_ID();
     auto site_index = siteID_to_index(site_ID);
 
-    auto extracter = AlleleExtracter(bubble_pair.first, bubble_pair.second,
-                                     genotyped_records);
-    RandomInclusiveInt rand(std::nullopt);
-    auto genotyped_site =
-        make_randomly_genotyped_site(&rand, extracter.get_alleles());
+    lvlgt_site_ptr genotyped_site;
+    if (simu_template.fixed_alleles[i].has_value())
+      genotyped_site =
+          make_randomly_genotyped_site(rand, *simu_template.fixed_alleles[i]);
+    else
+      genotyped_site = make_randomly_genotyped_site(
+          rand, AlleleExtracter(bubble_pair.first, bubble_pair.second,
+                                genotyped_records)
+                    .get_alleles());
     genotyped_site->set_pos(bubble_pair.first->get_pos());
     genotyped_site->set_site_end_node(bubble_pair.second);
 
@@ -74,6 +113,18 @@ lvlgt_site_ptr make_randomly_genotyped_site(RandomGenerator* const rand,
 
   return result;
 }
+
+strings get_lvl1_alleles(gt_sites const& genotyped_records,
+                         std::vector<std::size_t> const& lvl1_site_indices) {
+  strings result;
+  result.reserve(lvl1_site_indices.size());
+  for (auto const site_index : lvl1_site_indices) {
+    auto const& site = genotyped_records.at(site_index);
+    auto const gt = get_genotype_to_paste(site, 1).at(0);
+    result.push_back(site->get_alleles().at(gt).sequence);
+  }
+  return result;
+}
 }  // namespace gram::simulate
 
 SimulationGenotyper::SimulationGenotyper(coverage_Graph const& cov_graph,
@@ -84,60 +135,103 @@ SimulationGenotyper::SimulationGenotyper(coverage_Graph const& cov_graph,
   genotyped_records = input_sites;
 }
 
-void add_new_json(json_prg_ptr& simu_json, gtyper_ptr const& gtyper,
-                  SegmentTracker& tracker, bool& first,
-                  std::string const& sample_id, std::string const& desc) {
-  auto new_json = make_json_prg(gtyper, tracker);
-  if (first) {
-    simu_json = new_json;
-    simu_json->set_sample_info(sample_id, desc);
-    first = false;
-  } else {
-    new_json->set_sample_info(sample_id, desc);
-    simu_json->combine_with(*new_json);
-  }
+/**
+ * Combines the JSONs of a batch of paths into `simu_json`, each site in one go
+ * rather than one path at a time. Throws if a sample name is repeated.
+ */
+void add_new_jsons(JSON& simu_json,
+                   std::vector<json_prg_ptr> const& new_jsons) {
+  if (new_jsons.empty()) return;
+  std::size_t first_new{0};
+  if (simu_json.is_null()) simu_json = new_jsons.at(first_new++)->get_prg();
+
+  // Sample names go through the same duplicate check as
+  // `Json_Prg::combine_with`: induced sequences can share an ID
+  Json_Prg samples;
+  samples.get_prg().at("Samples") = std::move(simu_json.at("Samples"));
+  for (std::size_t k = first_new; k < new_jsons.size(); ++k)
+    samples.add_sample_names(new_jsons[k]->get_prg().at("Samples"), false);
+  simu_json.at("Samples") = std::move(samples.get_prg().at("Samples"));
+
+  std::string const gtyping_model = simu_json.at("Model");
+  auto& sites = simu_json.at("Sites");
+  parallel_for(sites.size(), [&](std::size_t j) {
+    std::vector<JSON> site_versions{std::move(sites[j])};
+    for (std::size_t k = first_new; k < new_jsons.size(); ++k)
+      site_versions.push_back(
+          std::move(new_jsons[k]->get_prg().at("Sites").at(j)));
+    sites[j] = combine_sites(std::move(site_versions), gtyping_model);
+  });
 }
 
+/**
+ * Paths are drawn in parallel, each with its own generator seeded from the
+ * run's seed and the path's index, so outputs only depend on the seed.
+ * Duplicate paths are detected by hashing the alleles they take at lvl1 sites.
+ */
 void simulate_paths(json_prg_ptr& simu_json, coverage_Graph const& cov_graph,
                     SimulateParams const& parameters) {
-  std::string desc{"path through prg made by gramtools simulate"}, sample_id;
-  unique_Fastas unique_simu_paths;
-  Fastas ordered_simu_paths;
-  bool first{true};
-
-  std::stringstream coords_file{""};
-  SegmentTracker tracker(coords_file);
-
-  uint64_t num_runs{0}, num_sampled{0};
-  while (num_runs < parameters.max_num_paths) {
-    num_runs++;
-    auto gtyper = std::make_shared<SimulationGenotyper>(cov_graph);
-    auto genotyped_records = gtyper->get_genotyped_records();
-    auto new_p_ref =
-        get_personalised_ref(cov_graph.root, genotyped_records, tracker).at(0);
-
-    if (unique_simu_paths.find(new_p_ref) != unique_simu_paths.end()) continue;
-
-    num_sampled++;
-    sample_id = parameters.sample_id + std::to_string(num_sampled);
-    new_p_ref.set_ID(sample_id);
-    new_p_ref.set_desc("made by gramtools simulate");
-    unique_simu_paths.insert(new_p_ref);
-    ordered_simu_paths.push_back(new_p_ref);
-
-    add_new_json(simu_json, gtyper, tracker, first, sample_id, desc);
-  }
+  std::string desc{"path through prg made by gramtools simulate"};
+  SimulationTemplate const simu_template(cov_graph);
+  SeedSize const master_seed = parameters.seed.has_value()
+                                   ? parameters.seed.value()
+                                   : RandomInclusiveInt(std::nullopt)();
+  std::unordered_set<strings, boost::hash<strings>> unique_paths;
+  std::ofstream fasta_fhandle(parameters.fasta_out_fpath);
+  JSON combined_json;
 
-  std::cout << "Made " << unique_simu_paths.size() << " simulated paths."
-            << std::endl;
+  uint64_t num_sampled{0};
+  for (uint64_t start = 0; start < parameters.max_num_paths;
+       start += SIMULATED_PATHS_PER_BATCH) {
+    std::size_t const batch_size = std::min<uint64_t>(
+        SIMULATED_PATHS_PER_BATCH, parameters.max_num_paths - start);
+    std::vector<std::shared_ptr<SimulationGenotyper>> gtypers(batch_size);
+    std::vector<strings> paths(batch_size);
+    parallel_for(batch_size, [&](std::size_t i) {
+      CounterRandomInt rand(derive_seed(master_seed, start + i));
+      gtypers[i] = std::make_shared<SimulationGenotyper>(simu_template, &rand);
+      paths[i] = get_lvl1_alleles(gtypers[i]->get_genotyped_records(),
+                                  simu_template.lvl1_site_indices);
+    });
 
-  // Write fasta
-  std::ofstream fasta_fhandle(parameters.fasta_out_fpath);
-  for (auto& simu_path : ordered_simu_paths)
-    fasta_fhandle << simu_path << std::endl;
+    std::vector<std::size_t> kept;
+    for (std::size_t i = 0; i < batch_size; ++i)
+      if (unique_paths.insert(std::move(paths[i])).second) kept.push_back(i);
+
+    Fastas p_refs(kept.size());
+    std::vector<json_prg_ptr> new_jsons(kept.size());
+    parallel_for(kept.size(), [&](std::size_t k) {
+      gtyper_ptr const gtyper = gtypers[kept[k]];
+      auto const sample_id =
+          parameters.sample_id + std::to_string(num_sampled + k + 1);
+      std::stringstream coords_file{""};
+      SegmentTracker tracker(coords_file);
+      p_refs[k] = get_personalised_ref(
+                      cov_graph.root, gtyper->get_genotyped_records(), tracker)
+                      .at(0);
+      p_refs[k].set_ID(sample_id);
+      p_refs[k].set_desc("made by gramtools simulate");
+
+      tracker.reset();
+      new_jsons[k] = make_json_prg(gtyper, tracker);
+      new_jsons[k]->set_sample_info(sample_id, desc);
+    });
+    num_sampled += kept.size();
+
+    for (auto const& p_ref : p_refs) fasta_fhandle << p_ref << std::endl;
+    add_new_jsons(combined_json, new_jsons);
+  }
   fasta_fhandle.close();
+
+  std::cout << "Made " << num_sampled << " simulated paths." << std::endl;
+  if (num_sampled > 0)
+    simu_json = std::make_shared<Json_Prg>(std::move(combined_json));
 }
 
+/**
+ * Sequences are induced in parallel, one batch of as many sequences as threads
+ * at a time, so that only one batch of sequences is held in memory.
+ */
 void induce_genotypes_all_seqs(json_prg_ptr& simu_json,
                                coverage_Graph const& input_cov_graph,
                                std::string const& fasta_fpath) {
@@ -148,34 +242,49 @@ void induce_genotypes_all_seqs(json_prg_ptr& simu_json,
   input_fasta(in, fhandle, is_gzipped(fasta_fpath));
   std::istream getter{&in};
 
-  auto template_sites = make_nulled_sites(input_cov_graph);
-  bool first{true};
-  std::stringstream coords_file{""};
-  SegmentTracker tracker(coords_file);
-  std::string line, fasta_id, fasta_seq,
-      desc{"induced genotypes made by gramtools simulate"};
+  auto const template_sites = make_nulled_sites(input_cov_graph);
+  std::string const desc{"induced genotypes made by gramtools simulate"};
+  std::size_t const batch_size = std::max(omp_get_max_threads(), 1);
+  std::vector<std::pair<std::string, std::string>> batch;  // ID, sequence
+  JSON combined_json;
+
+  auto const induce_batch = [&]() {
+    std::vector<json_prg_ptr> new_jsons(batch.size());
+    parallel_for(batch.size(), [&](std::size_t i) {
+      auto const& [fasta_id, fasta_seq] = batch[i];
+      auto gtyped_sites = induce_genotypes_one_seq(
+          template_sites, input_cov_graph, fasta_seq, fasta_id);
+      gtyper_ptr const gtyper =
+          std::make_shared<SimulationGenotyper>(input_cov_graph, gtyped_sites);
+      std::stringstream coords_file{""};
+      SegmentTracker tracker(coords_file);
+      new_jsons[i] = make_json_prg(gtyper, tracker);
+      new_jsons[i]->set_sample_info(fasta_id, desc);
+    });
+    add_new_jsons(combined_json, new_jsons);
+    batch.clear();
+  };
+
+  std::string line, fasta_id, fasta_seq;
+  auto const add_record = [&]() {
+    if (fasta_seq.empty() || fasta_id.empty()) return;
+    batch.emplace_back(fasta_id, std::move(fasta_seq));
+    if (batch.size() == batch_size) induce_batch();
+  };
   while (std::getline(getter, line)) {
     if (line[0] == '>') {
-      if (!fasta_seq.empty()) {
-        auto gtyped_sites = induce_genotypes_one_seq(
-            template_sites, input_cov_graph, fasta_seq, fasta_id);
-        auto gtyper = std::make_shared<SimulationGenotyper>(input_cov_graph,
-                                                            gtyped_sites);
-        add_new_json(simu_json, gtyper, tracker, first, fasta_id, desc);
-      }
+      add_record();
       fasta_seq.clear();
       fasta_id =
           line.substr(1, line.find(" ") - 1);  // Take first word of header only
     } else if (!fasta_id.empty())
       fasta_seq += line;
   }
-  if (!fasta_seq.empty() && !fasta_id.empty()) {
-    auto gtyped_sites = induce_genotypes_one_seq(
-        template_sites, input_cov_graph, fasta_seq, fasta_id);
-    auto gtyper =
-        std::make_shared<SimulationGenotyper>(input_cov_graph, gtyped_sites);
-    add_new_json(simu_json, gtyper, tracker, first, fasta_id, desc);
-  }
+  add_record();
+  induce_batch();
+
+  if (!combined_json.is_null())
+    simu_json = std::make_shared<Json_Prg>(std::move(combined_json));
 }
 
 void gram::commands::simulate::run(SimulateParams const& parameters) {
@@ -1,28 +1,50 @@
 /**
  * @file Combine JSON genotyped files into one
+ * All files are read at once, one chunk of sites at a time, and site j gets
+ * combined across all of them in one go.
+ * If fout ends in .gts, the files get appended to a genotype store instead.
  */
+#include <omp.h>
+#include <sys/resource.h>
+
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
-#include <nlohmann/json.hpp>
-
-#include "genotype/infer/output_specs/json_prg_spec.hpp"
+#include "genotype/infer/output_specs/genotype_store.hpp"
+#include "genotype/infer/output_specs/json_combine.hpp"
 
 namespace fs = std::filesystem;
-using JSON = nlohmann::json;
 using namespace gram::json;
 
+/** Caps the number of sites held in memory, across all input files */
+constexpr std::size_t MAX_SITES_IN_MEMORY{1000000};
+
 void usage(const char* argv[]) {
-  std::cout << "Usage: " << argv[0] << " fofn fout" << std::endl;
+  std::cout << "Usage: " << argv[0] << " fofn fout [max_threads]"
+            << std::endl;
   std::cout << "\t fofn: file of file names of the JSON files to combine"
             << std::endl;
-  std::cout << "\t fout: name of output combined JSON file" << std::endl;
+  std::cout << "\t fout: name of output combined JSON file, or of a genotype "
+               "store to append to if it ends in .gts"
+            << std::endl;
+  std::cout << "\t max_threads: maximum number of threads used. Default: 1"
+            << std::endl;
   exit(1);
 }
 
+/** All input files are open at once: allow as many as the system does */
+void raise_open_files_limit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+}
+
 int main(int argc, const char* argv[]) {
-  if (argc != 3) usage(argv);
+  if (argc != 3 && argc != 4) usage(argv);
   fs::path fofn(argv[1]);
   if (!fs::exists(fofn)) {
     std::cout << fofn << " not found.";
@@ -31,35 +53,57 @@ int main(int argc, const char* argv[]) {
     std::cout << fofn << " is empty.";
     usage(argv);
   }
+  std::size_t max_threads = 1;
+  if (argc == 4) max_threads = std::stoul(argv[3]);
+  if (max_threads == 0) usage(argv);
+  omp_set_num_threads(max_threads);
 
-  std::ofstream fout(argv[2]);
-  if (!fout.good()) {
-    std::cout << "Error: could not open " << argv[2] << std::endl;
-    usage(argv);
+  bool const to_store = fs::path(argv[2]).extension() == ".gts";
+  std::ofstream fout;
+  if (!to_store) {
+    fout.open(argv[2]);
+    if (!fout.good()) {
+      std::cout << "Error: could not open " << argv[2] << std::endl;
+      usage(argv);
+    }
   }
 
+  raise_open_files_limit();
   std::ifstream fin(fofn);
   std::string next_file;
-  JSON next_json;
-  Json_Prg combined_json;
-  bool first{true};
+  std::vector<std::string> fpaths;
+  std::vector<std::unique_ptr<std::ifstream>> input_files;
+  std::vector<std::istream*> inputs;
   while (std::getline(fin, next_file)) {
-    std::ifstream next_istream(next_file);
-    if (!next_istream.good()) {
+    if (next_file.empty()) continue;
+    input_files.push_back(std::make_unique<std::ifstream>(next_file));
+    if (!input_files.back()->good()) {
       std::cout << "Error: Could not open JSON file " << next_file << std::endl;
       exit(1);
     }
-    next_json.clear();
-    next_istream >> next_json;
-    if (first) {
-      combined_json.set_prg(next_json);
-      first = false;
-    }
+    fpaths.push_back(next_file);
+    inputs.push_back(input_files.back().get());
+  }
+
+  if (inputs.empty()) {
+    std::cout << fofn << " lists no JSON files.";
+    usage(argv);
+  }
 
-    else {
-      Json_Prg next_prg(next_json);
-      combined_json.combine_with(next_prg);
+  try {
+    if (to_store) {
+      GenotypeStore store(argv[2]);
+      for (std::size_t i = 0; i < inputs.size(); ++i) {
+        JsonSiteReader reader(*inputs[i], fpaths[i]);
+        store.append(reader);
+      }
+      return 0;
     }
+    auto const sites_per_chunk =
+        std::max<std::size_t>(1, MAX_SITES_IN_MEMORY / inputs.size());
+    combine_json_prgs(inputs, fpaths, fout, sites_per_chunk);
+  } catch (std::exception const& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    exit(1);
   }
-  fout << combined_json.get_prg();
 }
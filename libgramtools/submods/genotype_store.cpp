@@ -0,0 +1,81 @@
+/**
+ * @file Append genotyped JSON files to a genotype store, and convert a store
+ * back to a JSON or a vcf file.
+ */
+#include <omp.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "genotype/infer/output_specs/genotype_store.hpp"
+
+using namespace gram::json;
+
+void usage(const char* argv[]) {
+  std::cout << "Usage: " << argv[0] << " command store [args]" << std::endl;
+  std::cout << "\t append store json [json...]: append genotyped JSON files "
+               "to the store, which is created if it does not exist"
+            << std::endl;
+  std::cout << "\t to_json store fout [first last]: write the store as a "
+               "JSON file, or only the array of sites first (included) to "
+               "last (excluded)"
+            << std::endl;
+  std::cout << "\t to_vcf store fout [max_threads]: write the store as a "
+               "bgzipped multi-sample vcf file"
+            << std::endl;
+  exit(1);
+}
+
+void write_site_range(GenotypeStore const& store, std::ostream& out,
+                      std::size_t first, std::size_t last) {
+  out << '[';
+  bool first_site{true};
+  for (auto const& site : store.get_sites(first, last)) {
+    if (!first_site) out << ',';
+    first_site = false;
+    out << site.dump();
+  }
+  out << ']' << std::endl;
+}
+
+int main(int argc, const char* argv[]) {
+  if (argc < 4) usage(argv);
+  std::string const command{argv[1]};
+
+  try {
+    GenotypeStore store(argv[2]);
+    if (command == "append") {
+      for (int i = 3; i < argc; ++i) {
+        std::ifstream in(argv[i]);
+        if (!in.good()) {
+          std::cout << "Error: Could not open JSON file " << argv[i]
+                    << std::endl;
+          exit(1);
+        }
+        JsonSiteReader reader(in, argv[i]);
+        store.append(reader);
+      }
+    } else if (command == "to_json" && (argc == 4 || argc == 6)) {
+      std::ofstream fout(argv[3]);
+      if (!fout.good()) {
+        std::cout << "Error: could not open " << argv[3] << std::endl;
+        usage(argv);
+      }
+      if (argc == 6)
+        write_site_range(store, fout, std::stoul(argv[4]), std::stoul(argv[5]));
+      else
+        store.write_json(fout);
+    } else if (command == "to_vcf" && (argc == 4 || argc == 5)) {
+      std::size_t max_threads = 1;
+      if (argc == 5) max_threads = std::stoul(argv[4]);
+      if (max_threads == 0) usage(argv);
+      omp_set_num_threads(max_threads);
+      store.write_vcf(argv[3], max_threads);
+    } else
+      usage(argv);
+  } catch (std::exception const& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    exit(1);
+  }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file Merge coverage checkpoints made by `genotype` on the same PRG (eg from
+ * different sequencing runs of a sample) into one.
+ * The merged checkpoint can be genotyped using `genotype --from_checkpoint`.
+ */
+#include <omp.h>
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "common/parallel.hpp"
+#include "genotype/quasimap/coverage/checkpoint.hpp"
+
+namespace fs = std::filesystem;
+using namespace gram;
+
+void usage(const char* argv[]) {
+  std::cout << "Usage: " << argv[0] << " fofn fout [max_threads]"
+            << std::endl;
+  std::cout << "\t fofn: file of file names of the coverage checkpoints to "
+               "merge"
+            << std::endl;
+  std::cout << "\t fout: name of output merged coverage checkpoint"
+            << std::endl;
+  std::cout << "\t max_threads: maximum number of threads used. Default: 1"
+            << std::endl;
+  exit(1);
+}
+
+/**
+ * Loads a batch of checkpoints in parallel, and merges them pairwise.
+ * At most `batch.size()` checkpoints are held in memory at once.
+ */
+CoverageCheckpoint merge_batch(std::vector<std::string> const& batch) {
+  std::vector<CoverageCheckpoint> checkpoints(batch.size());
+  parallel_for(batch.size(), [&](std::size_t i) {
+    checkpoints[i] = read_checkpoint(batch[i]);
+  });
+
+  for (std::size_t stride = 1; stride < checkpoints.size(); stride *= 2) {
+    // Merges checkpoint i + stride into i, for i a multiple of 2 * stride
+    auto num_merges = (checkpoints.size() + stride - 1) / (2 * stride);
+    parallel_for(num_merges, [&](std::size_t merge_index) {
+      auto i = merge_index * 2 * stride;
+      checkpoints[i].merge(checkpoints[i + stride]);
+    });
+  }
+  return std::move(checkpoints.front());
+}
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3 && argc != 4) usage(argv);
+  fs::path fofn(argv[1]);
+  if (!fs::exists(fofn)) {
+    std::cout << fofn << " not found.";
+    usage(argv);
+  } else if (fs::is_empty(fofn)) {
+    std::cout << fofn << " is empty.";
+    usage(argv);
+  }
+  std::size_t max_threads = 1;
+  if (argc == 4) max_threads = std::stoul(argv[3]);
+  if (max_threads == 0) usage(argv);
+  omp_set_num_threads(max_threads);
+
+  std::ifstream fin(fofn);
+  std::vector<std::string> fpaths;
+  std::string next_file;
+  while (std::getline(fin, next_file)) {
+    if (next_file.empty()) continue;
+    if (!fs::exists(next_file)) {
+      std::cout << "Error: Could not find checkpoint " << next_file
+                << std::endl;
+      exit(1);
+    }
+    fpaths.push_back(next_file);
+  }
+
+  try {
+    CoverageCheckpoint merged;
+    bool first{true};
+    for (std::size_t start = 0; start < fpaths.size(); start += max_threads) {
+      auto end = std::min(start + max_threads, fpaths.size());
+      std::vector<std::string> batch{fpaths.begin() + start,
+                                     fpaths.begin() + end};
+      auto merged_batch = merge_batch(batch);
+      if (first) {
+        merged = std::move(merged_batch);
+        first = false;
+      } else
+        merged.merge(merged_batch);
+    }
+    write_checkpoint(argv[2], merged);
+  } catch (std::exception const& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    exit(1);
+  }
+  std::cout << "Merged " << fpaths.size() << " coverage checkpoints into "
+            << argv[2] << std::endl;
+}
@@ -75,3 +75,51 @@ TEST_F(TestRefMatchesFirstPrgPath, GzipCompressedCorrectRef_Passes) {
   boost::iostreams::copy(compressor, compressed);
   PrgRefChecker(compressed, cov_graph, true);  // Say input stream is gzipped
 }
+
+TEST_F(TestRefMatchesFirstPrgPath, RefLongerThanFirstPath_Fails) {
+  std::istringstream ss{"AACTCCAAACGT"};
+  EXPECT_THROW(PrgRefChecker(ss, cov_graph), std::runtime_error);
+}
+
+class TestRefMatchesLongFirstPrgPath : public ::testing::Test {
+ protected:
+  void SetUp() {
+    std::string const bases{"ACGT"};
+    for (std::size_t i = 0; i < 3 * REF_CHECK_BUFFER_SIZE; ++i)
+      first_path += bases[(i * i + i / 7) % 4];
+    cov_graph = setup_cov_graph(first_path.substr(0, 1000) + "[" +
+                                first_path.substr(1000, 2) + ",A]" +
+                                first_path.substr(1002));
+  }
+  /** Multi-line fasta, with several records */
+  std::string to_fasta(std::string const& ref) {
+    std::string result{">chrom1\n"};
+    for (std::size_t i = 0; i < ref.size(); i += 60) {
+      if (i == 90000) result += ">chrom2 second record\n";
+      result += ref.substr(i, 60) + "\n";
+    }
+    return result;
+  }
+  std::string first_path;
+  coverage_Graph cov_graph;
+};
+
+TEST_F(TestRefMatchesLongFirstPrgPath, CorrectMultiLineRef_Passes) {
+  std::istringstream ss{to_fasta(first_path)};
+  PrgRefChecker(ss, cov_graph);
+}
+
+TEST_F(TestRefMatchesLongFirstPrgPath, MismatchPastFirstBuffer_FailsAtIt) {
+  auto ref = first_path;
+  auto const mismatch_pos = REF_CHECK_BUFFER_SIZE + 12345;
+  ref[mismatch_pos] = ref[mismatch_pos] == 'A' ? 'C' : 'A';
+  std::istringstream ss{to_fasta(ref)};
+  try {
+    PrgRefChecker(ss, cov_graph);
+    FAIL() << "Expected a mismatch error";
+  } catch (std::runtime_error const& e) {
+    std::string const msg{e.what()};
+    EXPECT_NE(msg.find("from position " + std::to_string(mismatch_pos)),
+              std::string::npos);
+  }
+}
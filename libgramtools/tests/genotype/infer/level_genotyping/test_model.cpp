@@ -579,3 +579,38 @@ TEST_F(TestMaxLikelihoodCall, GivenNestingInconsistentBestAllele_NotCalled) {
   EXPECT_EQ(result.alleles, expected_alleles);
   EXPECT_EQ(result.genotype, GtypedIndices{1});
 }
+
+TEST(TestLevelGenotyperModel_ManyAlleles,
+     GivenBoundedHetSearch_SameCallAsExhaustiveSearch) {
+  // 20 alleles, all with some coverage, two of them well-supported
+  allele_vector alleles;
+  GroupedAlleleCounts gp_counts;
+  std::string const bases{"ACGT"};
+  for (AlleleId i = 0; i < 20; ++i) {
+    std::string sequence{bases[i % 4], bases[(i / 4) % 4], 'A'};
+    CovCount cov = (i == 3) ? 12 : (i == 11) ? 9 : 1 + i % 3;
+    alleles.push_back(Allele{sequence, {cov, cov, cov}, i});
+    gp_counts.insert({AlleleIds{i}, cov});
+  }
+  likelihood_related_stats l_stats =
+      LevelGenotyper::make_l_stats(20, 30, 0.01);
+
+  ModelData data(alleles, gp_counts, Ploidy::Diploid, &l_stats, false);
+  data.max_exhaustive_het_alleles = alleles.size();
+  auto exhaustive = LevelGenotyperModel(data);
+  // 20 homozygous + (20 choose 2) heterozygous
+  EXPECT_EQ(exhaustive.get_likelihoods().size(), 210);
+
+  data.max_exhaustive_het_alleles = 0;
+  auto bounded = LevelGenotyperModel(data);
+  EXPECT_LT(bounded.get_likelihoods().size(), 210);
+
+  auto expected_site = exhaustive.get_site();
+  auto result_site = bounded.get_site();
+  // Alleles 3 and 11, rescaled after the REF
+  GtypedIndices expected_gtype{1, 2};
+  EXPECT_EQ(expected_site->get_genotype(), expected_gtype);
+  EXPECT_EQ(result_site->get_genotype(), expected_site->get_genotype());
+  EXPECT_DOUBLE_EQ(bounded.get_genotype_confidence(),
+                   exhaustive.get_genotype_confidence());
+}
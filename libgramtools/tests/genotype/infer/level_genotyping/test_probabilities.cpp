@@ -95,6 +95,34 @@ TEST(LogPmfs, GivenTruthProbabilities_LogPmfValuesCorrect) {
   EXPECT_DOUBLE_EQ(res2, known2);
 }
 
+TEST(LogPmfTable, GivenIntegerCoverages_ExactPmfValues) {
+  auto pmf = std::make_shared<NegBinomLogPmf>(params{2.5, 0.5});
+  LogPmfTable table(pmf, 20);
+  for (double cov{0}; cov <= 20; ++cov)
+    EXPECT_DOUBLE_EQ(table(cov), (*pmf)(params{cov}));
+}
+
+TEST(LogPmfTable, GivenFractionalCoverages_CloseToPmfValues) {
+  auto pmf = std::make_shared<PoissonLogPmf>(params{15});
+  LogPmfTable table(pmf, 40);
+  for (double cov : {0.3, 2.5, 14.333, 15.8, 39.9})
+    EXPECT_NEAR(table(cov), (*pmf)(params{cov}), 1e-4);
+}
+
+TEST(LogPmfTable, GivenCoverageBeyondTable_ExactPmfValue) {
+  auto pmf = std::make_shared<PoissonLogPmf>(params{15});
+  LogPmfTable table(pmf, 10);
+  EXPECT_DOUBLE_EQ(table(10.5), (*pmf)(params{10.5}));
+  EXPECT_DOUBLE_EQ(table(100), (*pmf)(params{100}));
+}
+
+TEST(LikelihoodStats, FullDepthPmfIsTabulated) {
+  auto lstats = LevelGenotyper::make_l_stats(30, 0, 0.01);
+  EXPECT_GT(lstats.log_pmf_full_depth.size(), 30 * 64);
+  EXPECT_DOUBLE_EQ(lstats.log_pmf_full_depth(30),
+                   (*lstats.pmf_full_depth)(params{30}));
+}
+
 TEST(MinCovMoreLikelyThanError,
      GivenMeanDepthAndErrorRate_CorrectMinCovThreshold) {
   LevelGenotyper g;
@@ -5,12 +5,18 @@
  * those are required to work.
  */
 
+#include <omp.h>
+
+#include <filesystem>
+
 #include "../../../test_resources/test_resources.hpp"
 #include "../mocks.hpp"
 #include "genotype/infer/level_genotyping/runner.hpp"
 #include "genotype/infer/output_specs/make_json.hpp"
 #include "gtest/gtest.h"
 
+namespace fs = std::filesystem;
+
 TEST(LevelGenotyping, Given2SiteNonNestedPRG_CorrectGenotypes) {
   std::string prg{"AATAA5C6G6AA7C8G8AA"};
   prg_setup setup;
@@ -150,6 +156,38 @@ TEST_F(LG_SnpsNestedInTwoHaplotypes, MapReads_CorrectlyInvalidatedSites) {
   EXPECT_FLOAT_EQ(json_result.at("GT_CONF").at(0), 0.);
 }
 
+TEST(LevelGenotyping, GivenManyIndependentNestedSites_SameGenotypesAnyThreads) {
+  std::string prg{
+      "AATAA[CCC[A,G],T]AATCG[TT[A,C]GG,GG[T,G]GG]ATCCA[C,G]GTTAG[AA[C,T],G]"
+      "CA"};
+  GenomicRead_vector reads;
+  for (int i = 0; i < 5; i++) {
+    reads.push_back(GenomicRead("Read1", "AATAACCCGAATCG", "??????????????"));
+    reads.push_back(
+        GenomicRead("Read2", "GGTGGATCCAGGTTAGAAT", "???????????????????"));
+  }
+
+  auto const default_num_threads = omp_get_max_threads();
+  auto genotype_with = [&](int num_threads) {
+    prg_setup setup;
+    setup.setup_bracketed_prg(prg);
+    setup.quasimap_reads(reads);
+    omp_set_num_threads(num_threads);
+    LevelGenotyper genotyper(setup.prg_info.coverage_graph,
+                             setup.coverage.grouped_allele_counts,
+                             setup.read_stats, Ploidy::Haploid);
+    omp_set_num_threads(default_num_threads);
+    std::vector<std::pair<GtypedIndices, bool>> result;
+    for (auto const& site : genotyper.get_genotyped_records())
+      result.emplace_back(site->get_genotype(), site->has_filter("AMBIG"));
+    return result;
+  };
+
+  auto expected = genotype_with(1);
+  EXPECT_EQ(expected.size(), 8);
+  for (int i = 0; i < 5; i++) EXPECT_EQ(genotype_with(4), expected);
+}
+
 TEST(GCPSimulation, GivenDifferentNumGenotypedSites_ConsistentNumConfidences) {
   auto l_stats = LevelGenotyper::make_l_stats(20, 10, 0.1);
   Ploidy ploidy{Ploidy::Haploid};
@@ -170,6 +208,87 @@ TEST(GCPSimulation, GivenDifferentNumGenotypedSites_ConsistentNumConfidences) {
   EXPECT_EQ(CONF_DISTRIB_SIZE, confidences.size());
 }
 
+TEST(GCPSimulation, GivenSameLStats_SameConfidencesAnyThreads) {
+  auto l_stats = LevelGenotyper::make_l_stats(20, 30, 0.01);
+  auto const default_num_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  auto expected =
+      LevelGenotyper::simulate_gtconfs(l_stats, Ploidy::Diploid, 1000);
+  omp_set_num_threads(4);
+  auto result =
+      LevelGenotyper::simulate_gtconfs(l_stats, Ploidy::Diploid, 1000);
+  omp_set_num_threads(default_num_threads);
+  EXPECT_EQ(result, expected);
+
+  // Fewer simulations are the first of more simulations
+  auto fewer = LevelGenotyper::simulate_gtconfs(l_stats, Ploidy::Diploid, 150);
+  EXPECT_TRUE(std::equal(fewer.begin(), fewer.end(), expected.begin()));
+}
+
+TEST(GCPSimulation, GivenCacheDir_CachedConfidencesReused) {
+  fs::path const cache_dir = fs::path(__FILE__)
+                                 .parent_path()
+                                 .parent_path()
+                                 .parent_path()
+                                 .parent_path() /
+                             "test_data" / "tmp_gcp_cache";
+  auto l_stats = LevelGenotyper::make_l_stats(19.6, 10, 0.01);
+  gt_sites sites(10);
+  for (auto& site : sites) {
+    auto lvlgt_site = std::make_shared<LevelGenotypedSite>();
+    lvlgt_site->set_gt_conf(10);
+    site = std::static_pointer_cast<gt_site>(lvlgt_site);
+  }
+
+  auto first = LevelGenotyper::get_gtconf_distrib(
+      sites, l_stats, Ploidy::Haploid, cache_dir.string());
+  EXPECT_EQ(std::distance(fs::directory_iterator(cache_dir),
+                          fs::directory_iterator{}),
+            1);
+  auto second = LevelGenotyper::get_gtconf_distrib(
+      sites, l_stats, Ploidy::Haploid, cache_dir.string());
+
+  // Similar depth and error rate round to the same model, and reuse the cache
+  auto similar_l_stats = LevelGenotyper::make_l_stats(19.8, 10, 0.0101);
+  auto similar = LevelGenotyper::get_gtconf_distrib(
+      sites, similar_l_stats, Ploidy::Haploid, cache_dir.string());
+  auto num_cached = std::distance(fs::directory_iterator(cache_dir),
+                                  fs::directory_iterator{});
+  fs::remove_all(cache_dir);
+
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(similar, first);
+  EXPECT_EQ(num_cached, 1);
+  // A fresh cache gives the same confidences
+  auto fresh = LevelGenotyper::get_gtconf_distrib(
+      sites, similar_l_stats, Ploidy::Haploid, cache_dir.string());
+  fs::remove_all(cache_dir);
+  EXPECT_EQ(fresh, first);
+}
+
+TEST(GCPSimulation, GivenCacheDirAndDifferentDepths_SeparateCacheEntries) {
+  fs::path const cache_dir = fs::path(__FILE__)
+                                 .parent_path()
+                                 .parent_path()
+                                 .parent_path()
+                                 .parent_path() /
+                             "test_data" / "tmp_gcp_cache";
+  gt_sites sites(10);
+  for (auto& site : sites) {
+    auto lvlgt_site = std::make_shared<LevelGenotypedSite>();
+    lvlgt_site->set_gt_conf(10);
+    site = std::static_pointer_cast<gt_site>(lvlgt_site);
+  }
+  for (auto const mean_cov : {20.0, 40.0})
+    LevelGenotyper::get_gtconf_distrib(
+        sites, LevelGenotyper::make_l_stats(mean_cov, 60, 0.01),
+        Ploidy::Diploid, cache_dir.string());
+  auto num_cached = std::distance(fs::directory_iterator(cache_dir),
+                                  fs::directory_iterator{});
+  fs::remove_all(cache_dir);
+  EXPECT_EQ(num_cached, 2);
+}
+
 TEST(LevelGenotyperInvalidation,
      GivenChildMapAndCandidateHaplos_CorrectHaplosWithSites) {
   // site 7 lives on haplogroup 0 of site 5, and sites 9 and 11 live on its
@@ -20,6 +20,33 @@ TEST(ExtractRefAllele, GivenSiteNodesInGraph_CorrectRefAllele) {
   EXPECT_EQ(ref_allele.sequence, "CTGC");
 }
 
+rope_vector to_ropes(allele_vector const& alleles) {
+  rope_vector result;
+  for (auto const& allele : alleles) {
+    AlleleRope rope{allele.haplogroup};
+    rope.append(allele);
+    result.push_back(rope);
+  }
+  return result;
+}
+
+TEST(AlleleRope, GivenNodeAndAllelePieces_MaterialisesConcatenation) {
+  coverage_Node node{"ATT", 120, 1, 1};
+  node.get_ref_to_coverage() = PerBaseCoverage{4, 5, 6};
+  Allele nested{"CG", {1, 2}, 3, false};
+
+  AlleleRope rope{1};
+  rope.append(node);
+  rope.append(nested);
+  rope.append(node);
+  EXPECT_EQ(rope.size(), 8);
+
+  Allele expected{"ATTCGATT", {4, 5, 6, 1, 2, 4, 5, 6}, 1};
+  auto result = rope.materialise();
+  EXPECT_EQ(result, expected);
+  EXPECT_FALSE(result.callable);
+}
+
 class AlleleCombineTest : public ::testing::Test {
  protected:
   AlleleCombineTest() {}
@@ -42,7 +69,8 @@ TEST_F(AlleleCombineTest,
   site.set_genotype(GtypedIndices{0});
 
   allele_vector one_allele{existing_alleles.at(0)};
-  auto result = test_extracter.allele_combine(one_allele, 0);
+  auto result =
+      materialise(test_extracter.allele_combine(to_ropes(one_allele), 0));
   allele_vector expected{{"ATTGCCC", {0, 1, 2, 3, 1, 1, 1}, 0}};
   EXPECT_EQ(result, expected);
 }
@@ -61,7 +89,8 @@ TEST_F(AlleleCombineTest,
   allele_vector one_allele{existing_alleles.at(0)};
   EXPECT_TRUE(one_allele.at(0).callable);
 
-  auto result = test_extracter.allele_combine(one_allele, 0);
+  auto result =
+      materialise(test_extracter.allele_combine(to_ropes(one_allele), 0));
   allele_vector expected{
       {"ATTGGGG", {0, 1, 2, 3, 2, 2, 2}, 0},
       {"ATTGAAA", {0, 1, 2, 3, 2, 1, 0}, 0},
@@ -78,7 +107,8 @@ TEST_F(AlleleCombineTest, TwoAllelesNullGenotype_oneCorrectCombinationAllele) {
 
   allele_vector one_allele(existing_alleles.begin(),
                            existing_alleles.begin() + 1);
-  auto result = test_extracter.allele_combine(one_allele, 0);
+  auto result =
+      materialise(test_extracter.allele_combine(to_ropes(one_allele), 0));
   allele_vector expected{{"ATTGTTT", {0, 1, 2, 3, 1, 1, 1}, 0}};
 
   EXPECT_EQ(result, expected);
@@ -97,7 +127,8 @@ TEST_F(AlleleCombineTest,
           1  // Note the pasted allele's haplogroup should get ignored
       }});
 
-  auto result = test_extracter.allele_combine(existing_alleles, 0);
+  auto result = materialise(
+      test_extracter.allele_combine(to_ropes(existing_alleles), 0));
   allele_vector expected{
       {"ATTGCCC", {0, 1, 2, 3, 1, 1, 1}, 0},
       {"ATTGTTT", {0, 1, 2, 3, 5, 5, 5}, 0},
@@ -119,12 +150,13 @@ TEST(AllelePasteTest,
   covG_ptr cov_Node = boost::make_shared<coverage_Node>("ATTCGC", 120, 1, 1);
 
   AlleleExtracter extracter;
-  extracter.allele_paste(existing_alleles, cov_Node);
+  auto existing_ropes = to_ropes(existing_alleles);
+  extracter.allele_paste(existing_ropes, cov_Node);
 
   allele_vector expected{{"ATTGATTCGC", {0, 1, 2, 3, 0, 0, 0, 0, 0, 0}, 0},
                          {"ATCGATTCGC", {0, 0, 1, 1, 0, 0, 0, 0, 0, 0}, 0}};
 
-  EXPECT_EQ(existing_alleles, expected);
+  EXPECT_EQ(materialise(existing_ropes), expected);
 }
 
 class AlleleExtracter_NestedPRG : public ::testing::Test {
@@ -1,11 +1,24 @@
+#include <htslib/vcf.h>
+
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+#include "genotype/infer/level_genotyping/runner.hpp"
+#include "genotype/infer/output_specs/genotype_store.hpp"
+#include "genotype/infer/output_specs/json_combine.hpp"
 #include "genotype/infer/output_specs/json_prg_spec.hpp"
 #include "genotype/infer/output_specs/json_site_spec.hpp"
+#include "genotype/infer/output_specs/make_json.hpp"
+#include "genotype/infer/output_specs/segment_tracker.hpp"
 #include "genotype/infer/types.hpp"
 #include "gtest/gtest.h"
+#include "test_resources.hpp"
 
 using namespace gram;
 using namespace gram::json;
 using namespace gram::genotype::infer;
+namespace fs = std::filesystem;
 
 namespace gram::json {
 bool operator==(site_rescaler const& first, site_rescaler const& second) {
@@ -337,3 +350,252 @@ TEST(PRG_Combine_Successs2_cpy, GivenTwoPrgs_CorrectCombined) {
   site2_sample1.combine_with(site2_sample2);
   EXPECT_EQ(data.prg1.get_prg().at("Sites").at(1), site2_sample1.get_site());
 }
+
+class PRG_Combine_Streamed : public ::testing::Test {
+ protected:
+  void SetUp() {
+    JSON_data_store data;
+    Json_Prg prg3;
+    prg3.set_sample_info("Blorp", "");
+    prg3.add_site(data.site1_samples.at(2));
+    MockJsonSite null_site({"AAAAAAA", "AA"}, {0}, {0}, {3, 4}, 7, 50,
+                           "gene2");
+    null_site.make_null();
+    prg3.add_site(std::make_shared<MockJsonSite>(null_site));
+
+    dumps = {data.prg1.get_prg().dump(), data.prg2.get_prg().dump(),
+             prg3.get_prg().dump()};
+    names = {"prg1", "prg2", "prg3"};
+  }
+
+  std::string combine_streamed(std::size_t sites_per_chunk) {
+    std::vector<std::istringstream> streams;
+    for (auto const& dump : dumps) streams.emplace_back(dump);
+    std::vector<std::istream*> inputs;
+    for (auto& stream : streams) inputs.push_back(&stream);
+    std::ostringstream out;
+    combine_json_prgs(inputs, names, out, sites_per_chunk);
+    return out.str();
+  }
+
+  std::vector<std::string> dumps, names;
+};
+
+TEST_F(PRG_Combine_Streamed, GivenThreePrgs_SameAsCombinedPairwise) {
+  Json_Prg expected(JSON::parse(dumps.at(0)));
+  for (std::size_t i = 1; i < dumps.size(); ++i) {
+    Json_Prg next(JSON::parse(dumps.at(i)));
+    expected.combine_with(next);
+  }
+  EXPECT_EQ(expected.get_prg().at("Samples").size(), 3);
+
+  for (std::size_t sites_per_chunk : {1, 2, 10})
+    EXPECT_EQ(combine_streamed(sites_per_chunk), expected.get_prg().dump());
+}
+
+TEST_F(PRG_Combine_Streamed, GivenOnePrg_Unchanged) {
+  dumps.resize(1);
+  EXPECT_EQ(combine_streamed(1), dumps.at(0));
+}
+
+TEST_F(PRG_Combine_Streamed, GivenDifferentNumOfSites_Fails) {
+  auto prg = JSON::parse(dumps.at(2));
+  prg.at("Sites").erase(1);
+  dumps.at(2) = prg.dump();
+  EXPECT_THROW(combine_streamed(10), JSONCombineException);
+}
+
+TEST(JsonSiteReader, GivenSitesNotLastEntry_Fails) {
+  std::istringstream in{R"({"Sites":[],"Samples":[]})"};
+  EXPECT_THROW(JsonSiteReader(in, "in"), JSONConsistencyException);
+}
+
+TEST(JsonPrgWrite, GivenGenotypedPrg_StreamedSameAsBuiltInMemory) {
+  prg_setup setup;
+  setup.setup_bracketed_prg("AATAA[CCC[A,G],T]AATCG[TT[A,C]GG,GG[T,G]GG]CA");
+  GenomicRead_vector reads;
+  for (int i = 0; i < 5; i++)
+    reads.push_back(GenomicRead("Read", "AATAACCCGAATCG", "??????????????"));
+  setup.quasimap_reads(reads);
+  auto gtyper = std::make_shared<LevelGenotyper>(
+      setup.prg_info.coverage_graph, setup.coverage.grouped_allele_counts,
+      setup.read_stats, Ploidy::Haploid);
+
+  std::stringstream coords;
+  SegmentTracker tracker(coords);
+  auto json_prg = make_json_prg(gtyper, tracker);
+  json_prg->set_sample_info("sample", "test");
+  auto const expected = json_prg->get_prg().dump();
+
+  tracker.reset();
+  std::stringstream result;
+  write_json_prg(result, gtyper, tracker, "sample", "test");
+  EXPECT_EQ(result.str(), expected);
+  EXPECT_EQ(JSON::parse(result.str()).at("Sites").size(), 6);
+}
+
+class GenotypeStoreIO : public PRG_Combine_Streamed {
+ protected:
+  void SetUp() {
+    PRG_Combine_Streamed::SetUp();
+    // As in genotyped JSONs, the store needs one FT entry per sample
+    for (auto& dump : dumps) {
+      auto prg = JSON::parse(dump);
+      for (auto& site : prg.at("Sites"))
+        site.at("FT") = JSON(std::vector<strings>(site.at("GT").size()));
+      dump = prg.dump();
+    }
+  }
+  void TearDown() { fs::remove_all(dirpath); }
+
+  void append_all(std::size_t sites_per_chunk) {
+    GenotypeStore store(dirpath, sites_per_chunk);
+    for (std::size_t i = 0; i < dumps.size(); ++i) {
+      std::istringstream in{dumps.at(i)};
+      JsonSiteReader reader(in, names.at(i));
+      store.append(reader);
+    }
+  }
+
+  std::string const dirpath =
+      (fs::path(__FILE__).parent_path().parent_path().parent_path() /
+       "test_data" / "tmp_genotype_store.gts")
+          .generic_string();
+};
+
+TEST_F(GenotypeStoreIO, GivenThreePrgs_SameJsonAsCombined) {
+  for (std::size_t sites_per_chunk : {1, 2, 10}) {
+    fs::remove_all(dirpath);
+    append_all(sites_per_chunk);
+    std::ostringstream out;
+    GenotypeStore(dirpath).write_json(out);
+    EXPECT_EQ(JSON::parse(out.str()), JSON::parse(combine_streamed(10)));
+  }
+}
+
+TEST_F(GenotypeStoreIO, GivenSiteRange_SameSitesAsCombined) {
+  append_all(1);
+  GenotypeStore store(dirpath);
+  auto const expected = JSON::parse(combine_streamed(10)).at("Sites");
+  ASSERT_EQ(store.num_sites(), 2);
+  EXPECT_EQ(store.num_batches(), 3);
+
+  auto const second_site = store.get_sites(1, 2);
+  ASSERT_EQ(second_site.size(), 1);
+  EXPECT_EQ(second_site.at(0), expected.at(1));
+  EXPECT_TRUE(store.get_sites(1, 1).empty());
+  EXPECT_THROW(store.get_sites(1, 3), GenotypeStoreException);
+}
+
+TEST_F(GenotypeStoreIO, GivenConcurrentAppends_NoBatchLost) {
+  // All stores get opened before any append, as by concurrent processes
+  std::vector<GenotypeStore> stores;
+  for (std::size_t i = 0; i < dumps.size(); ++i)
+    stores.emplace_back(dirpath, 1);
+  std::vector<std::thread> appenders;
+  for (std::size_t i = 0; i < dumps.size(); ++i)
+    appenders.emplace_back([&, i]() {
+      std::istringstream in{dumps.at(i)};
+      JsonSiteReader reader(in, names.at(i));
+      stores.at(i).append(reader);
+    });
+  for (auto& appender : appenders) appender.join();
+
+  GenotypeStore store(dirpath);
+  EXPECT_EQ(store.num_batches(), dumps.size());
+  std::size_t expected_num_samples{0};
+  for (auto const& dump : dumps)
+    expected_num_samples += JSON::parse(dump).at("Samples").size();
+  EXPECT_EQ(store.get_header().at("Samples").size(), expected_num_samples);
+  std::ostringstream out;
+  EXPECT_NO_THROW(store.write_json(out));
+}
+
+TEST_F(GenotypeStoreIO, GivenIncompatiblePrg_FailsAndStoreUnchanged) {
+  auto prg = JSON::parse(dumps.at(2));
+  dumps.resize(2);
+  append_all(1);
+  prg.at("Sites").erase(1);
+  std::istringstream in{prg.dump()};
+  JsonSiteReader reader(in, "bad");
+
+  GenotypeStore store(dirpath);
+  EXPECT_THROW(store.append(reader), JSONCombineException);
+  EXPECT_EQ(store.num_batches(), 2);
+  EXPECT_EQ(GenotypeStore(dirpath).get_header().at("Samples").size(), 2);
+  EXPECT_FALSE(fs::exists(fs::path(dirpath) / "batch_2"));
+}
+
+TEST_F(GenotypeStoreIO, GivenThreePrgs_VcfHasLvl1SitesWithPaddedCalls) {
+  // Only the second site is written. There, the first sample is made diploid
+  // and the third sample, a null call, gets a filter.
+  for (auto& dump : dumps) {
+    auto prg = JSON::parse(dump);
+    prg.at("Lvl1_Sites") = JSON::array({1});
+    dump = prg.dump();
+  }
+  auto prg1 = JSON::parse(dumps.at(0));
+  prg1.at("Sites").at(1).at("GT") = JSON::array({JSON::array({1, 1})});
+  prg1.at("Sites").at(1).at("HAPG") = JSON::array({JSON::array({1, 1})});
+  dumps.at(0) = prg1.dump();
+  auto prg3 = JSON::parse(dumps.at(2));
+  prg3.at("Sites").at(1).at("FT") = JSON::array({JSON::array({"AMBIG"})});
+  dumps.at(2) = prg3.dump();
+
+  append_all(1);
+  auto const expected = JSON::parse(combine_streamed(10)).at("Sites").at(1);
+  auto const num_alleles = expected.at("ALS").size();
+  ASSERT_EQ(num_alleles, 3);
+  auto const vcf_fpath = (fs::path(dirpath) / "store.vcf.gz").generic_string();
+  GenotypeStore(dirpath).write_vcf(vcf_fpath);
+
+  htsFile* fin = bcf_open(vcf_fpath.c_str(), "r");
+  ASSERT_NE(fin, nullptr);
+  bcf_hdr_t* hdr = bcf_hdr_read(fin);
+  ASSERT_EQ(bcf_hdr_nsamples(hdr), 3);
+  bcf1_t* record = bcf_init();
+  int32_t* gts = nullptr;
+  float* covs = nullptr;
+  char** filters = nullptr;
+  int gts_size{0}, covs_size{0}, filters_size{0};
+  std::size_t num_records{0};
+  while (bcf_read(fin, hdr, record) == 0) {
+    ++num_records;
+    bcf_unpack(record, BCF_UN_ALL);
+    EXPECT_EQ(std::string(bcf_hdr_id2name(hdr, record->rid)), "gene2");
+    EXPECT_EQ(record->pos + 1, 50);
+    ASSERT_EQ(record->n_allele, num_alleles);
+
+    // Haploid calls are padded to the largest ploidy
+    ASSERT_EQ(bcf_get_genotypes(hdr, record, &gts, &gts_size), 6);
+    for (std::size_t j = 0; j < 2; ++j) {
+      EXPECT_FALSE(bcf_gt_is_missing(gts[j]));
+      EXPECT_EQ(bcf_gt_allele(gts[j]), expected.at("GT").at(0).at(j));
+    }
+    EXPECT_TRUE(bcf_gt_is_missing(gts[4]));
+    EXPECT_EQ(gts[5], bcf_int32_vector_end);
+
+    // Null calls keep their uncombined coverages, written as missing
+    ASSERT_EQ(bcf_get_format_float(hdr, record, "COV", &covs, &covs_size),
+              static_cast<int>(3 * num_alleles));
+    for (std::size_t j = 0; j < num_alleles; ++j) {
+      EXPECT_EQ(covs[j], expected.at("COV").at(0).at(j).get<float>());
+      EXPECT_TRUE(bcf_float_is_missing(covs[2 * num_alleles + j]));
+    }
+
+    ASSERT_EQ(bcf_get_format_string(hdr, record, "FT", &filters,
+                                    &filters_size),
+              3);
+    EXPECT_EQ(std::string(filters[0]), "PASS");
+    EXPECT_EQ(std::string(filters[2]), "AMBIG");
+  }
+  EXPECT_EQ(num_records, 1);
+
+  if (filters != nullptr) free(filters[0]);
+  free(filters);
+  free(covs);
+  free(gts);
+  bcf_destroy(record);
+  bcf_hdr_destroy(hdr);
+  bcf_close(fin);
+}
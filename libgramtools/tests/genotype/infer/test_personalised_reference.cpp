@@ -1,3 +1,7 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
 #include "gtest/gtest.h"
 
 #include "genotype/infer/output_specs/segment_tracker.hpp"
@@ -9,6 +13,7 @@
 
 using namespace gram::submods;
 using namespace gram::genotype;
+namespace fs = std::filesystem;
 
 class Alleles_To_Paste : public ::testing::Test {
  protected:
@@ -215,3 +220,65 @@ TEST_F(Personalised_Ref, GivenSeqS2Tracker_CorrectMultiSegRef) {
   str_vec expected{{"ATCGCTT"}, {"TATC"}};
   EXPECT_EQ(res, expected);
 }
+
+TEST_F(Personalised_Ref, GivenHetSameGts_DedupedRefsKeepFirstOccurrence) {
+  sites.at(0)->set_genotype(GtypedIndices{0, 0});
+  sites.at(2)->set_genotype(GtypedIndices{1, 1});
+  sites.at(3)->set_genotype(GtypedIndices{1, 1});
+  auto result_vec = get_personalised_ref(graph_root, sites, s1_tracker);
+  result_vec.at(0).set_ID("first");
+  result_vec.at(1).set_ID("second");
+
+  auto result = dedupe_sequences(result_vec);
+  ASSERT_EQ(result.size(), 1);
+  EXPECT_EQ(result.at(0).get_ID(), "first");
+  EXPECT_EQ(result.at(0).get_sequence(), "ATCGCTTTTTG");
+}
+
+class Fasta_Write : public ::testing::Test {
+ protected:
+  void SetUp() {
+    std::string long_seq(FASTA_LWIDTH + 5, 'A');
+    long_seq.back() = 'C';
+    fastas.resize(2);
+    fastas.at(0).set_ID("seg1");
+    fastas.at(0).add_sequence(long_seq);
+    fastas.at(1).set_ID("seg2");
+    fastas.at(1).add_sequence("ACGT");
+    add_description(fastas, "desc");
+  }
+  void TearDown() {
+    fs::remove(fpath);
+    fs::remove(fpath + ".fai");
+  }
+
+  std::string read_file(std::string const& path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+  }
+
+  Fastas fastas;
+  std::string const fpath =
+      (fs::path(__FILE__).parent_path().parent_path().parent_path() /
+       "test_data" / "tmp_personalised_reference.fasta")
+          .generic_string();
+};
+
+TEST_F(Fasta_Write, GivenFastas_SameAsStreamedFastas) {
+  write_fastas(fastas, fpath);
+  std::stringstream expected;
+  for (auto const& fasta : fastas) expected << fasta << std::endl;
+  EXPECT_EQ(read_file(fpath), expected.str());
+}
+
+TEST_F(Fasta_Write, GivenFastas_CorrectFaidxIndex) {
+  write_fastas(fastas, fpath);
+  // Offsets of the first base: after ">seg1 desc\n", then after the 2 lines
+  // of seg1 and ">seg2 desc\n"
+  std::string expected{
+      "seg1\t65\t11\t60\t61\n"
+      "seg2\t4\t89\t4\t5\n"};
+  EXPECT_EQ(read_file(fpath + ".fai"), expected);
+}
@@ -237,9 +237,10 @@ TEST(PbCovRecorder_NodeProcessing, ProcessNewCovNode_CorrectDummyCovNodeMade) {
   PbCovRecorder pb_rec;
   covG_ptr cov_node =
       boost::make_shared<coverage_Node>(coverage_Node{"ACTG", 102, 5, 2});
-  realCov_to_dummyCov expected_mapping{{cov_node, DummyCovNode(1, 3, 4)}};
+  realCov_to_dummyCov expected_mapping{
+      {cov_node.get(), DummyCovNode(1, 3, 4)}};
 
-  pb_rec.process_Node(cov_node, 1, 3);
+  pb_rec.process_Node(cov_node.get(), 1, 3);
   EXPECT_EQ(expected_mapping, pb_rec.get_cov_mapping());
 }
 
@@ -247,34 +248,64 @@ TEST(PbCovRecorder_NodeProcessing,
      ProcessExistingCovNode_CorrectlyUpdatedDummyCovNode) {
   covG_ptr cov_node =
       boost::make_shared<coverage_Node>(coverage_Node{"ACTGCC", 99, 5, 2});
-  realCov_to_dummyCov existing_mapping{{cov_node, DummyCovNode{1, 3, 6}}};
+  realCov_to_dummyCov existing_mapping{
+      {cov_node.get(), DummyCovNode{1, 3, 6}}};
   PbCovRecorder pb_rec(existing_mapping);
-  pb_rec.process_Node(cov_node, 2, 5);
+  pb_rec.process_Node(cov_node.get(), 2, 5);
 
-  realCov_to_dummyCov expected_mapping{{cov_node, DummyCovNode(1, 5, 6)}};
+  realCov_to_dummyCov expected_mapping{
+      {cov_node.get(), DummyCovNode(1, 5, 6)}};
 
   EXPECT_EQ(expected_mapping, pb_rec.get_cov_mapping());
 }
 
+/**
+ * Models a read with very many mapping instances: quadratic lookups in the
+ * recorder's node mapping would make this test very slow.
+ */
+TEST(PbCovRecorder_NodeProcessing,
+     ProcessManyCovNodesTwice_CorrectDummyCovNodesMade) {
+  std::size_t const num_nodes{200000};
+  std::vector<covG_ptr> cov_nodes;
+  cov_nodes.reserve(num_nodes);
+  for (std::size_t i = 0; i < num_nodes; ++i)
+    cov_nodes.push_back(boost::make_shared<coverage_Node>(
+        coverage_Node{"ACTG", static_cast<int>(i), 5, 2}));
+
+  PbCovRecorder pb_rec;
+  for (auto const& cov_node : cov_nodes)
+    pb_rec.process_Node(cov_node.get(), 1, 2);
+  for (auto const& cov_node : cov_nodes)
+    pb_rec.process_Node(cov_node.get(), 2, 3);
+
+  auto const& cov_mapping = pb_rec.get_cov_mapping();
+  EXPECT_EQ(num_nodes, cov_mapping.size());
+  for (auto const& cov_node : cov_nodes) {
+    auto dummy_cov_node = cov_mapping.find(cov_node.get());
+    ASSERT_NE(nullptr, dummy_cov_node);
+    EXPECT_EQ(DummyCovNode(1, 3, 4), *dummy_cov_node);
+  }
+}
+
 /**
  * Tests full coverage recording by inspecting `DummyCovNode`s and
  * `coverage_Node`s
  */
 using dummy_cov_nodes = std::vector<DummyCovNode>;
 
-dummy_cov_nodes collect_dummy_cov_nodes(coverage_Graph const& cov_graph,
-                                        prg_positions positions,
-                                        realCov_to_dummyCov cov_mapping) {
+dummy_cov_nodes collect_dummy_cov_nodes(
+    coverage_Graph const& cov_graph, prg_positions positions,
+    realCov_to_dummyCov const& cov_mapping) {
   dummy_cov_nodes result(positions.size());
-  covG_ptr accessed_node;
   std::size_t index{0};
 
   for (auto& pos : positions) {
-    accessed_node = cov_graph.random_access[pos].node;
-    if (cov_mapping.find(accessed_node) == cov_mapping.end())
+    auto accessed_dummy =
+        cov_mapping.find(cov_graph.random_access[pos].node.get());
+    if (accessed_dummy == nullptr)
       result[index] = DummyCovNode{};
     else
-      result[index] = cov_mapping.at(accessed_node);
+      result[index] = *accessed_dummy;
     index++;
   }
   return result;
@@ -600,3 +631,27 @@ TEST_F(PbCovRecorder_nestedDeletion,
 
   EXPECT_EQ(expected_coverage, actual_coverage);
 }
+
+TEST_F(PbCovRecorder_nestedDeletion,
+       reusedRecorder_onlyKeepsLastReadDummiesAndRecordsAllCoverage) {
+  // PRG: "AT[GC[GCC,CCGC],T]TTTT"; Reads: "CGCCTT", then "ATTTT"
+  PbCovRecorder recorder;
+  recorder.record(prg_info, SearchStates{simple_read_1}, 6);
+  recorder.record(prg_info, SearchStates{simple_read_2}, 5);
+
+  auto actual_dummies = collect_dummy_cov_nodes(prg_info.coverage_graph,
+                                                all_sequence_node_positions,
+                                                recorder.get_cov_mapping());
+  dummy_cov_nodes expected_dummies{DummyCovNode{},        DummyCovNode{},
+                                   DummyCovNode{},        DummyCovNode{},
+                                   DummyCovNode{0, 0, 1}, DummyCovNode{}};
+  EXPECT_EQ(expected_dummies, actual_dummies);
+
+  auto actual_coverage =
+      collect_coverage(prg_info.coverage_graph, all_sequence_node_positions);
+  SitePbCoverage expected_coverage{
+      PerBaseCoverage{},        PerBaseCoverage{0, 1},
+      PerBaseCoverage{1, 1, 1}, PerBaseCoverage{0, 0, 0, 0},
+      PerBaseCoverage{1},       PerBaseCoverage{}};
+  EXPECT_EQ(expected_coverage, actual_coverage);
+}
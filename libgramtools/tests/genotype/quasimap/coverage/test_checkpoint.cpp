@@ -0,0 +1,145 @@
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+#include "genotype/quasimap/coverage/checkpoint.hpp"
+#include "test_resources.hpp"
+
+namespace fs = std::filesystem;
+auto const checkpoint_test_data_dir =
+    fs::path(__FILE__).parent_path().parent_path().parent_path().parent_path() /
+    "test_data";
+
+std::vector<PerBaseCoverage> collect_node_coverages(
+    coverage_Graph const& cov_graph) {
+  std::vector<PerBaseCoverage> result;
+  for (auto const& node : coverage_nodes(cov_graph))
+    result.push_back(node->get_coverage());
+  return result;
+}
+
+class CoverageCheckpointIO : public ::testing::Test {
+ protected:
+  void SetUp() {
+    GenomicRead_vector reads{GenomicRead{"Read1", "GGGGGCCC", "IIIIIIII"},
+                             GenomicRead{"Read2", "GCCCC", "IIIII"},
+                             GenomicRead{"Read3", "GCCCC", "IIIII"},
+                             GenomicRead{"Read4", "GCCC", "IIII"}};
+    mapped.setup_bracketed_prg(prg);
+    mapped.quasimap_reads(reads);
+    coverage::dump::checkpoint(fpath, mapped.coverage,
+                               mapped.prg_info.coverage_graph,
+                               mapped.read_stats);
+  }
+  void TearDown() { fs::remove(fpath); }
+
+  std::string const prg{"G[GG[G,A]G,C]CCC"};
+  std::string const fpath =
+      (checkpoint_test_data_dir / "tmp_checkpoint.bin").generic_string();
+  prg_setup mapped;
+};
+
+TEST_F(CoverageCheckpointIO, NodeCoverage_ListedOncePerAlleleNode) {
+  // Alleles: GG, G, A, G, C
+  auto result = coverage_nodes(mapped.prg_info.coverage_graph).size();
+  EXPECT_EQ(result, 5);
+}
+
+TEST_F(CoverageCheckpointIO, ReloadIntoFreshPRG_SameCoverage) {
+  prg_setup reloaded;
+  reloaded.setup_bracketed_prg(prg);
+  ASSERT_NE(collect_node_coverages(reloaded.prg_info.coverage_graph),
+            collect_node_coverages(mapped.prg_info.coverage_graph));
+
+  ReadStats reloaded_stats;
+  auto result =
+      coverage::load::checkpoint(fpath, reloaded.prg_info, reloaded_stats);
+
+  EXPECT_EQ(result.allele_sum_coverage, mapped.coverage.allele_sum_coverage);
+  EXPECT_EQ(result.grouped_allele_counts,
+            mapped.coverage.grouped_allele_counts);
+  EXPECT_EQ(collect_node_coverages(reloaded.prg_info.coverage_graph),
+            collect_node_coverages(mapped.prg_info.coverage_graph));
+
+  auto const& expected_stats = mapped.read_stats;
+  EXPECT_DOUBLE_EQ(reloaded_stats.get_mean_cov(),
+                   expected_stats.get_mean_cov());
+  EXPECT_DOUBLE_EQ(reloaded_stats.get_var_cov(), expected_stats.get_var_cov());
+  EXPECT_EQ(reloaded_stats.get_num_sites_total(),
+            expected_stats.get_num_sites_total());
+  EXPECT_DOUBLE_EQ(reloaded_stats.get_mean_pb_error(),
+                   expected_stats.get_mean_pb_error());
+  EXPECT_EQ(reloaded_stats.get_max_read_len(),
+            expected_stats.get_max_read_len());
+}
+
+TEST_F(CoverageCheckpointIO, ReloadIntoDifferentPRG_Throws) {
+  prg_setup other;
+  other.setup_bracketed_prg("G[GG[G,A]G,C]CC[C,T]");
+  ReadStats reloaded_stats;
+  EXPECT_THROW(
+      coverage::load::checkpoint(fpath, other.prg_info, reloaded_stats),
+      IncompatibleCheckpoint);
+}
+
+TEST_F(CoverageCheckpointIO, MergeWithItself_DoubledCoverageOnReload) {
+  auto merged = read_checkpoint(fpath);
+  merged.merge(read_checkpoint(fpath));
+  write_checkpoint(fpath, merged);
+
+  prg_setup reloaded;
+  reloaded.setup_bracketed_prg(prg);
+  ReadStats reloaded_stats;
+  auto result =
+      coverage::load::checkpoint(fpath, reloaded.prg_info, reloaded_stats);
+
+  auto expected_sums = mapped.coverage.allele_sum_coverage;
+  for (auto& site : expected_sums)
+    for (auto& count : site) count *= 2;
+  EXPECT_EQ(result.allele_sum_coverage, expected_sums);
+
+  auto expected_node_coverages =
+      collect_node_coverages(mapped.prg_info.coverage_graph);
+  for (auto& node_coverage : expected_node_coverages)
+    for (auto& count : node_coverage) count *= 2;
+  EXPECT_EQ(collect_node_coverages(reloaded.prg_info.coverage_graph),
+            expected_node_coverages);
+
+  // Coverage depth gets recomputed from the merged coverage
+  EXPECT_DOUBLE_EQ(reloaded_stats.get_mean_cov(),
+                   2 * mapped.read_stats.get_mean_cov());
+  EXPECT_DOUBLE_EQ(reloaded_stats.get_mean_pb_error(),
+                   mapped.read_stats.get_mean_pb_error());
+}
+
+TEST(CoverageCheckpointMerge, GroupedCounts_AddedPerGroup) {
+  CoverageCheckpoint first, second;
+  first.grouped_allele_counts = {{{AlleleIds{0, 1}, 2}, {AlleleIds{1}, 1}}};
+  second.grouped_allele_counts = {{{AlleleIds{0, 1}, 3}, {AlleleIds{2}, 4}}};
+
+  first.merge(second);
+  SitesGroupedAlleleCounts expected{
+      {{AlleleIds{0, 1}, 5}, {AlleleIds{1}, 1}, {AlleleIds{2}, 4}}};
+  EXPECT_EQ(first.grouped_allele_counts, expected);
+}
+
+TEST(CoverageCheckpointMerge, LargeCounts_Saturate) {
+  CoverageCheckpoint first, second;
+  first.allele_sum_coverage = {{UINT16_MAX - 1, 1}};
+  second.allele_sum_coverage = {{5, 1}};
+  first.node_coverages = {{UINT16_MAX, 0}};
+  second.node_coverages = {{1, 1}};
+
+  first.merge(second);
+  AlleleSumCoverage expected_sums{{UINT16_MAX, 2}};
+  std::vector<PerBaseCoverage> expected_node_coverages{{UINT16_MAX, 1}};
+  EXPECT_EQ(first.allele_sum_coverage, expected_sums);
+  EXPECT_EQ(first.node_coverages, expected_node_coverages);
+}
+
+TEST(CoverageCheckpointMerge, DifferentShapes_Throws) {
+  CoverageCheckpoint first, second;
+  first.node_coverages = {{0, 0}};
+  second.node_coverages = {{0, 0, 0}};
+  EXPECT_THROW(first.merge(second), IncompatibleCheckpoint);
+}
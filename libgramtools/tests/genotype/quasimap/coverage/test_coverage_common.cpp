@@ -297,6 +297,34 @@ TEST(RandomInclusiveInt, GivenSize2IntervalAndNoSeed_ReturnsInInclusiveRange) {
   EXPECT_TRUE(result <= 2);
 }
 
+TEST(CounterRandomInt, GivenKey_ReturnsKnownAnswers) {
+  CounterRandomInt r{42};
+  EXPECT_EQ(r.generate(1, 2), 2);
+  CounterRandomInt r2{200};
+  EXPECT_EQ(r2.generate(1, 2), 1);
+}
+
+TEST(CounterRandomInt, GivenSameKey_SameDraws) {
+  CounterRandomInt r1{7}, r2{7};
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(r1.generate(1, 100), r2.generate(1, 100));
+}
+
+TEST(CounterRandomInt, GivenIntervals_ReturnsInInclusiveRange) {
+  CounterRandomInt r{56};
+  EXPECT_EQ(r.generate(3, 3), 3);
+  for (int i = 0; i < 100; ++i) {
+    auto result = r.generate(1, 3);
+    EXPECT_TRUE(result >= 1 and result <= 3);
+  }
+}
+
+TEST(DeriveSeed, DifferentIndicesOrMasterSeeds_DifferentSeeds) {
+  EXPECT_EQ(derive_seed(42, 10), derive_seed(42, 10));
+  EXPECT_NE(derive_seed(42, 10), derive_seed(42, 11));
+  EXPECT_NE(derive_seed(42, 10), derive_seed(43, 10));
+}
+
 class MappingInstanceSelector_addSearchStates : public ::testing::Test {
  protected:
   // In this example we pretend we have mapped "TAA" to the graph.
@@ -349,6 +377,37 @@ TEST_F(MappingInstanceSelector_addSearchStates,
   EXPECT_EQ(selector.usps, expected_map);
 }
 
+TEST_F(MappingInstanceSelector_addSearchStates,
+       partitionSearchStates_sameClassesAsFullProcessing) {
+  SearchStates all_ss{s1, s2, s3};
+  MappingInstanceSelector full{&prg_info};
+  full.process_searchstates(all_ss);
+  selector.partition_searchstates(all_ss);
+
+  ASSERT_EQ(selector.usps.size(), full.usps.size());
+  auto full_it = full.usps.begin();
+  for (auto const &entry : selector.usps) {
+    EXPECT_EQ(entry.first, full_it->first);
+    EXPECT_EQ(entry.second.first, full_it->second.first);
+    EXPECT_TRUE(entry.second.second.empty());
+    ++full_it;
+  }
+}
+
+TEST_F(MappingInstanceSelector_addSearchStates,
+       partitionThenSelect_lociResolvedForSelectedClassOnly) {
+  selector.partition_searchstates(SearchStates{s1, s2, s3});
+  selector.apply_selection(0);
+
+  SelectedMapping selection = selector.get_selection();
+  EXPECT_EQ(selection.navigational_search_states, (SearchStates{s1, s2}));
+  uniqueLoci expected_loci{VariantLocus{5, FIRST_ALLELE},
+                           VariantLocus{7, FIRST_ALLELE},
+                           VariantLocus{5, FIRST_ALLELE + 1}};
+  EXPECT_EQ(selection.equivalence_class_loci, expected_loci);
+  EXPECT_TRUE(selector.usps.at(SitePath{9}).second.empty());
+}
+
 class MappingInstanceSelector_select : public ::testing::Test {
   /*
    * There are four `SearchState`s: two go through two alleles of the same site
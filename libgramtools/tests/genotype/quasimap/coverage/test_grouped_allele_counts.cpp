@@ -7,6 +7,48 @@
 
 using namespace gram::submods;
 
+TEST(AlleleGroup, InsertOutOfOrder_IteratesInIncreasingOrder) {
+  AlleleGroup group;
+  group.insert(5);
+  group.insert(0);
+  group.insert(63);
+  group.insert(5);
+
+  AlleleIds result{group.begin(), group.end()};
+  AlleleIds expected{0, 5, 63};
+  EXPECT_EQ(result, expected);
+  EXPECT_EQ(group.size(), 3);
+  EXPECT_EQ(group.to_ids(), expected);
+}
+
+TEST(AlleleGroup, SameAllelesDifferentInsertionOrder_EqualAndSameHash) {
+  AlleleGroup first{3, 1}, second{AlleleIds{1, 3}};
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first.hash(), second.hash());
+  EXPECT_NE(first, AlleleGroup({1}));
+}
+
+TEST(AlleleGroup, Contains) {
+  AlleleGroup group{1, 3};
+  EXPECT_TRUE(group.contains(3));
+  EXPECT_FALSE(group.contains(2));
+  EXPECT_FALSE(group.contains(200));
+}
+
+TEST(AlleleGroup, WideAlleleIds_FallBackToSortedIds) {
+  AlleleGroup group{70, 2};
+  group.insert(64);
+  group.insert(2);
+
+  AlleleIds expected{2, 64, 70};
+  EXPECT_EQ(group.to_ids(), expected);
+  EXPECT_EQ(AlleleIds(group.begin(), group.end()), expected);
+  EXPECT_EQ(group.size(), 3);
+  EXPECT_TRUE(group.contains(64));
+  EXPECT_FALSE(group.contains(3));
+  EXPECT_EQ(group, AlleleGroup(expected));
+}
+
 TEST(GroupedAlleleCount, GivenTwoVariantSites_CorrectEmptySitesVectorSize) {
   auto prg_raw = encode_prg("gct5c6g6t6ac7cc8a8");
   auto prg_info = generate_prg_info(prg_raw);
@@ -86,7 +128,7 @@ TEST(GroupedAlleleCount, GivenSitesGroupedAlleleCounts_CorrectHashing) {
 
   // Test allele IDs in the gped allele counts are all registered and hashed
   HashSet<AlleleIds> allele_ids;
-  for (auto const& entry : result) allele_ids.insert(entry.first);
+  for (auto const& entry : result) allele_ids.insert(entry.first.to_ids());
   HashSet<AlleleIds> expected_allele_ids = {
       AlleleIds{1, 3},
       AlleleIds{2},
@@ -240,3 +282,30 @@ TEST_F(TestGetJSON, TwoSites_CorrectFullJson) {
       expected_all_counts + std::string("}}");
   EXPECT_EQ(result, expected);
 }
+
+TEST_F(TestGetJSON, StreamedJson_SameAsBuiltJson) {
+  sites.push_back(site1);
+  sites.push_back(site2);
+  std::stringstream out;
+  write_grouped_allele_counts(out, sites, group_ids);
+
+  std::string expected =
+      std::string(R"({"grouped_allele_counts":{"allele_groups":)") +
+      expected_allele_groups + std::string(R"(,"site_counts":)") +
+      expected_all_counts + std::string("}}");
+  EXPECT_EQ(out.str(), expected);
+  EXPECT_EQ(JSON::parse(out.str()), get_json(sites, group_ids));
+}
+
+TEST(GroupedAlleleCountStreamedJson, ManyGroups_OrderedByNumericGroupID) {
+  SitesGroupedAlleleCounts sites(1);
+  for (AlleleId allele = 0; allele < 12; ++allele)
+    sites[0][AlleleIds{allele}] = allele + 1;
+  auto group_ids = hash_allele_groups(sites);
+
+  std::stringstream out;
+  write_grouped_allele_counts(out, sites, group_ids);
+  auto result = out.str();
+  EXPECT_LT(result.find(R"("9":)"), result.find(R"("10":)"));
+  EXPECT_EQ(JSON::parse(result), get_json(sites, group_ids));
+}
@@ -182,7 +182,7 @@ TEST(Coverage, ReadMapsToThreePositions_CorrectAlleleCoverage) {
   const auto read = encode_dna_bases("tagt");
 
   // Chooses mapping instance in site 5 only
-  SeedSize const random_seed1 = 42;
+  SeedSize const random_seed1 = 3;
   quasimap_read(read, setup.coverage, setup.kmer_index, setup.prg_info,
                 setup.parameters, setup.quasimap_stats, random_seed1);
   auto &result = setup.coverage.allele_sum_coverage;
@@ -338,6 +338,61 @@ TEST(Coverage, MappingMultipleIdenticalReads_CorrectAlleleCoverage) {
   EXPECT_EQ(pbCovResult, pbCovExpected);
 }
 
+TEST(Coverage, ReplayingDuplicateReadMapping_SameCoverageAsMappingEachCopy) {
+  std::string const prg{"gcac5t6g6c6ta7t8c8cta"};
+  auto const read = encode_dna_bases("accta");
+  Seeds const selection_seeds{10, 200, 3000, 40000};
+
+  prg_setup mapped_each;
+  mapped_each.setup_numbered_prg(prg);
+  for (auto const &seed : selection_seeds)
+    quasimap_read(read, mapped_each.coverage, mapped_each.kmer_index,
+                  mapped_each.prg_info, mapped_each.parameters,
+                  mapped_each.quasimap_stats, seed);
+
+  prg_setup replayed;
+  replayed.setup_numbered_prg(prg);
+  auto const read_mapping = map_read(read, replayed.kmer_index,
+                                     replayed.prg_info, replayed.parameters);
+  for (auto const &seed : selection_seeds)
+    record_read_mapping(read_mapping, read.size(), replayed.coverage,
+                        replayed.quasimap_stats, replayed.prg_info,
+                        seed);
+
+  EXPECT_EQ(replayed.coverage.allele_sum_coverage,
+            mapped_each.coverage.allele_sum_coverage);
+  EXPECT_EQ(replayed.coverage.grouped_allele_counts,
+            mapped_each.coverage.grouped_allele_counts);
+  EXPECT_EQ(coverage::generate::allele_base_non_nested(replayed.prg_info),
+            coverage::generate::allele_base_non_nested(mapped_each.prg_info));
+  EXPECT_EQ(replayed.quasimap_stats.exact_mapped_reads_count, 4);
+}
+
+TEST(Coverage, DuplicateReadsInBuffer_EachDistinctReadMappedOnce) {
+  prg_setup setup;
+  setup.setup_numbered_prg("gct5c6g6T6AG7T8c8cta");
+  std::vector<Sequence> reads_buffer{
+      encode_dna_bases("tagt"), encode_dna_bases("tagt"), Sequence{},
+      encode_dna_bases("cagt"), encode_dna_bases("tagt")};
+  MappedReadsCache cache;
+
+  auto result = map_distinct_reads(reads_buffer, cache, setup.parameters,
+                                   setup.kmer_index, setup.prg_info);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(result.at(2), nullptr);
+  EXPECT_EQ(result.at(0), result.at(1));
+  EXPECT_EQ(result.at(0), result.at(4));
+  EXPECT_NE(result.at(0), result.at(3));
+  EXPECT_EQ(result.at(0)->forward.status, MappingStatus::mapped);
+
+  // Reads already seen in a previous buffer are not mapped again
+  std::vector<Sequence> next_buffer{encode_dna_bases("cagt")};
+  auto next_result = map_distinct_reads(next_buffer, cache, setup.parameters,
+                                        setup.kmer_index, setup.prg_info);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(next_result.at(0), result.at(3));
+}
+
 TEST(Coverage, MappingThreeReadsIdenticalKmers_CorrectAlleleCoverage) {
   prg_setup setup;
   setup.setup_numbered_prg("gct5c6g6t6ag7t8c8cta");
@@ -392,7 +447,7 @@ TEST(Coverage, MappingThreeReadsOneReadMapsTwice_CorrectAlleleCoverage) {
       encode_dna_bases("gcact"),
   };
 
-  SeedSize const random_seed = 200;
+  SeedSize const random_seed = 1;
   for (const auto &read : reads) {
     quasimap_read(read, setup.coverage, setup.kmer_index, setup.prg_info,
                   setup.parameters, setup.quasimap_stats, random_seed);
@@ -417,6 +472,96 @@ TEST(KmerIndexQuasimap, KmerAbsentFromKmerIndex_NoSearchStatesReturned) {
   EXPECT_EQ(search_states.size(), 0);
 }
 
+TEST(BatchedSearch, ReadsOfDifferentFates_SameSearchStatesAsSingleReadSearch) {
+  prg_setup setup;
+  setup.setup_bracketed_prg("gc[a,c[t,g]a]tt[c,cc]ag[a,g]t", 3);
+  // Reads mapping in one or more places, reads not mapping, a read made of
+  // its kmer only
+  Sequences reads{encode_dna_bases("gcattccag"), encode_dna_bases("cgattc"),
+                  encode_dna_bases("ttcag"),     encode_dna_bases("aaaaaa"),
+                  encode_dna_bases("gcaatt"),    encode_dna_bases("agt"),
+                  encode_dna_bases("ccagatt")};
+  auto const &kmer_size = setup.parameters.kmers_size;
+
+  auto result = search_reads_backwards(reads, kmer_size, setup.kmer_index,
+                                       setup.prg_info);
+  ASSERT_EQ(result.size(), reads.size());
+  for (std::size_t i = 0; i < reads.size(); ++i) {
+    auto kmer = get_last_kmer_in_read(kmer_size, reads[i]);
+    auto expected = search_read_backwards(reads[i], kmer, setup.kmer_index,
+                                          setup.prg_info);
+    EXPECT_EQ(result[i], expected);
+  }
+}
+
+TEST(BatchedSearch, MapReads_SameMappingsAsSingleReadMapping) {
+  prg_setup setup;
+  setup.setup_numbered_prg("gct5c6g6T6AG7T8c8cta");
+  Sequences reads{encode_dna_bases("tagt"), encode_dna_bases("ttttt"),
+                  encode_dna_bases("ctagt"), encode_dna_bases("cagtcta")};
+
+  auto result = map_reads(reads, setup.kmer_index, setup.prg_info,
+                          setup.parameters);
+  ASSERT_EQ(result.size(), reads.size());
+  for (std::size_t i = 0; i < reads.size(); ++i) {
+    auto expected = map_read(reads[i], setup.kmer_index, setup.prg_info,
+                             setup.parameters);
+    EXPECT_EQ(result[i].status, expected.status);
+    EXPECT_EQ(result[i].search_states, expected.search_states);
+  }
+}
+
+TEST(OccurrenceCap, DownsampleOccurrences_EvenlySpreadAndPathsKept) {
+  VariantSitePath path{VariantLocus{5, 1}};
+  SearchStates search_states{SearchState{SA_Interval{10, 15}, path},
+                             SearchState{SA_Interval{20, 21}}};
+  EXPECT_EQ(count_occurrences(search_states), 8);
+
+  // Kept occurrences: 0, 2, 4, 6 out of 8
+  auto result = downsample_occurrences(search_states, 4);
+  SearchStates expected{SearchState{SA_Interval{10, 10}, path},
+                        SearchState{SA_Interval{12, 12}, path},
+                        SearchState{SA_Interval{14, 14}, path},
+                        SearchState{SA_Interval{20, 20}}};
+  EXPECT_EQ(result, expected);
+
+  // Adjacent kept occurrences get grouped
+  EXPECT_EQ(downsample_occurrences(search_states, 7).size(), 2);
+  EXPECT_EQ(count_occurrences(downsample_occurrences(search_states, 7)), 7);
+  EXPECT_EQ(downsample_occurrences(search_states, 8), search_states);
+}
+
+TEST(OccurrenceCap, ReadOverCap_SkippedOrDownsampled) {
+  prg_setup setup;
+  // "ag" occurs five times
+  setup.setup_numbered_prg("agtag5c6g6agcagag");
+  auto const read = encode_dna_bases("ag");
+
+  auto uncapped = map_read(read, setup.kmer_index, setup.prg_info,
+                           setup.parameters);
+  EXPECT_EQ(uncapped.status, MappingStatus::mapped);
+
+  setup.parameters.max_read_occurrences = 3;
+  auto skipped = map_read(read, setup.kmer_index, setup.prg_info,
+                          setup.parameters);
+  EXPECT_EQ(skipped.status, MappingStatus::repetitive);
+  record_read_mapping(skipped, read.size(), setup.coverage,
+                      setup.quasimap_stats, setup.prg_info, 0);
+  EXPECT_EQ(setup.quasimap_stats.repetitive_reads_count, 1);
+  EXPECT_EQ(setup.quasimap_stats.exact_mapped_reads_count, 0);
+
+  setup.parameters.repetitive_reads_policy = RepetitiveReadsPolicy::Downsample;
+  auto downsampled = map_read(read, setup.kmer_index, setup.prg_info,
+                              setup.parameters);
+  EXPECT_EQ(downsampled.status, MappingStatus::mapped);
+  EXPECT_TRUE(downsampled.downsampled);
+  EXPECT_EQ(count_occurrences(downsampled.search_states), 3);
+  record_read_mapping(downsampled, read.size(), setup.coverage,
+                      setup.quasimap_stats, setup.prg_info, 0);
+  EXPECT_EQ(setup.quasimap_stats.repetitive_reads_count, 2);
+  EXPECT_EQ(setup.quasimap_stats.exact_mapped_reads_count, 1);
+}
+
 TEST(vBWTJump_andBWTExtension, InitiallyInSite_HaveExitedSite) {
   auto prg_raw = encode_prg("gcgct5c6G6t6agtcct");
   auto prg_info = generate_prg_info(prg_raw);
@@ -38,6 +38,38 @@ TEST(ReadProcessingStats, GivenOneOKAndOneEmptyGenomicRead_CorrectStats) {
   EXPECT_FLOAT_EQ(r.get_mean_pb_error(), 0.001);
 }
 
+TEST(ReadProcessingStats, RecordReadsOneByOne_SameStatsAsFromReadVector) {
+  GenomicRead_vector reads{GenomicRead{"Read1", "AAAA", "5555"},
+                           GenomicRead{"Read2", "", ""},
+                           GenomicRead{"Read3", "CCCCCC", "??????"}};
+  ReadStats expected;
+  expected.compute_base_error_rate(reads);
+
+  ReadStats result;
+  for (auto const& read : reads) result.record_read(read);
+  result.finalise_base_error_rate();
+
+  EXPECT_EQ(result.get_num_bases_processed(),
+            expected.get_num_bases_processed());
+  EXPECT_EQ(result.get_num_no_qual_reads(), expected.get_num_no_qual_reads());
+  EXPECT_EQ(result.get_max_read_len(), 6);
+  EXPECT_DOUBLE_EQ(result.get_mean_pb_error(), expected.get_mean_pb_error());
+}
+
+TEST(ReadProcessingStats, RecordMoreThanRequiredReads_ExtraReadsIgnored) {
+  ReadStats r;
+  GenomicRead const sampled{"Read", "AAAA", "5555"};
+  for (int i = 0; i < NUM_READS_USED; ++i) r.record_read(sampled);
+  EXPECT_FALSE(r.needs_more_reads());
+
+  r.record_read(GenomicRead{"Extra", "AAAAAAAA", "!!!!!!!!"});
+  r.finalise_base_error_rate();
+
+  EXPECT_EQ(r.get_num_bases_processed(), 4 * NUM_READS_USED);
+  EXPECT_EQ(r.get_max_read_len(), 4);
+  EXPECT_FLOAT_EQ(r.get_mean_pb_error(), 0.01);
+}
+
 /**
  * Coverage mean and variance
  * Notes:
@@ -1,3 +1,5 @@
+#include <omp.h>
+
 #include <filesystem>
 
 #include "gtest/gtest.h"
@@ -59,6 +61,48 @@ TEST(PRG_Conversion, ints_to_string_to_ints) {
   EXPECT_EQ(res2, expected_vec);
 }
 
+TEST(PRG_Conversion, EncodePrg) {
+  marker_vec expected{1, 5, 3, 6, 4, 6, 2, 2, 2, 2, 11, 3, 12, 4, 4, 4, 4, 12};
+  EXPECT_EQ(encode_prg("a5g6t6cccc11g12tttt12"), expected);
+}
+
+TEST(PRG_Conversion, EncodeLargePrgInChunks_SameAsWholePrg) {
+  std::string prg_raw;
+  marker_vec expected;
+  Marker site_marker{5};
+  while (prg_raw.size() < 4 * ENCODE_PRG_MIN_CHUNK_SIZE + 7) {
+    auto const site = std::to_string(site_marker),
+               allele = std::to_string(site_marker + 1);
+    prg_raw += "ac" + site + "t" + allele + "gg" + allele;
+    marker_vec unit{1, 2, site_marker, 4, site_marker + 1, 3, 3,
+                    site_marker + 1};
+    expected.insert(expected.end(), unit.begin(), unit.end());
+    site_marker += 2;
+  }
+  auto const default_num_threads = omp_get_max_threads();
+  omp_set_num_threads(4);
+  auto result = encode_prg(prg_raw);
+  omp_set_num_threads(default_num_threads);
+  EXPECT_EQ(result, expected);
+}
+
+TEST(PRG_Conversion, EncodePrgWithChunkSplitInMarker_SplitMovedPastMarker) {
+  // Two chunks, whose split point falls between the '3' and the '4'
+  std::size_t const marker_start{ENCODE_PRG_MIN_CHUNK_SIZE - 3};
+  std::string prg_raw(2 * ENCODE_PRG_MIN_CHUNK_SIZE, 'a');
+  prg_raw.replace(marker_start, 7, "1234567");
+
+  marker_vec expected(marker_start, 1);
+  expected.push_back(1234567);
+  expected.insert(expected.end(), prg_raw.size() - marker_start - 7, 1);
+
+  auto const default_num_threads = omp_get_max_threads();
+  omp_set_num_threads(4);
+  auto result = encode_prg(prg_raw);
+  omp_set_num_threads(default_num_threads);
+  EXPECT_EQ(result, expected);
+}
+
 /********************/
 /* PRG_String class */
 /********************/
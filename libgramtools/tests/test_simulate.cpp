@@ -1,4 +1,10 @@
+#include <filesystem>
+#include <fstream>
+
 #include "gtest/gtest.h"
+#include "genotype/infer/allele_extracter.hpp"
+#include "genotype/infer/output_specs/segment_tracker.hpp"
+#include "genotype/infer/personalised_reference.hpp"
 #include "prg/coverage_graph.hpp"
 #include "prg/linearised_prg.hpp"
 #include "simulate/induce_genotypes.hpp"
@@ -6,6 +12,8 @@
 #include "test_resources/mocks.hpp"
 
 using namespace gram::simulate;
+using namespace gram::genotype;
+namespace fs = std::filesystem;
 
 class MakeRandomGenotypedSite : public ::testing::Test {
  protected:
@@ -49,6 +57,71 @@ TEST_F(MakeRandomGenotypedSite, GivenIgnoreREFAllele_CorrectSite) {
   EXPECT_EQ(site->get_alleles(), expected_als);
 }
 
+class SimulationFromTemplate : public ::testing::Test {
+ protected:
+  coverage_Graph g;
+  SimulationFromTemplate() {
+    auto encoded_prg = prg_string_to_ints("AA[A,C,G]TG[AC,[G,T]CA]CCC");
+    g = coverage_Graph{PRG_String{encoded_prg}};
+  }
+};
+
+TEST_F(SimulationFromTemplate, FixedAllelesOnlyForSitesWithoutNestedSites) {
+  SimulationTemplate simu_template(g);
+  ASSERT_EQ(simu_template.bubbles.size(), 3);
+  std::size_t num_fixed{0};
+  gt_sites no_records(3);
+  for (std::size_t i = 0; i < simu_template.bubbles.size(); ++i) {
+    auto const& bubble = simu_template.bubbles[i];
+    auto const& fixed = simu_template.fixed_alleles[i];
+    if (!fixed.has_value()) continue;
+    ++num_fixed;
+    auto expected =
+        AlleleExtracter(bubble.first, bubble.second, no_records).get_alleles();
+    EXPECT_EQ(*fixed, expected);
+  }
+  EXPECT_EQ(num_fixed, 2);
+
+  std::vector<std::size_t> expected_lvl1{0, 1};
+  EXPECT_EQ(simu_template.lvl1_site_indices, expected_lvl1);
+}
+
+TEST_F(SimulationFromTemplate, SameSeed_SameGenotypes) {
+  SimulationTemplate simu_template(g);
+  for (uint64_t index = 0; index < 20; ++index) {
+    CounterRandomInt rand1(derive_seed(42, index)),
+        rand2(derive_seed(42, index));
+    SimulationGenotyper gtyper1(simu_template, &rand1),
+        gtyper2(simu_template, &rand2);
+    auto const& records1 = gtyper1.get_genotyped_records();
+    auto const& records2 = gtyper2.get_genotyped_records();
+    ASSERT_EQ(records1.size(), records2.size());
+    for (std::size_t i = 0; i < records1.size(); ++i) {
+      EXPECT_EQ(records1[i]->get_alleles(), records2[i]->get_alleles());
+      EXPECT_EQ(records1[i]->get_genotype(), records2[i]->get_genotype());
+    }
+    EXPECT_EQ(get_lvl1_alleles(records1, simu_template.lvl1_site_indices),
+              get_lvl1_alleles(records2, simu_template.lvl1_site_indices));
+  }
+}
+
+TEST_F(SimulationFromTemplate, Lvl1AllelesAreThePastedAlleles) {
+  SimulationTemplate simu_template(g);
+  CounterRandomInt rand(derive_seed(7, 0));
+  SimulationGenotyper gtyper(simu_template, &rand);
+  auto lvl1_alleles = get_lvl1_alleles(gtyper.get_genotyped_records(),
+                                       simu_template.lvl1_site_indices);
+  ASSERT_EQ(lvl1_alleles.size(), 2);
+
+  std::stringstream coords_file{""};
+  SegmentTracker tracker(coords_file);
+  auto p_ref =
+      get_personalised_ref(g.root, gtyper.get_genotyped_records(), tracker)
+          .at(0);
+  EXPECT_EQ(p_ref.get_sequence(),
+            "AA" + lvl1_alleles[0] + "TG" + lvl1_alleles[1] + "CCC");
+}
+
 class TestInduceGenotypes_ThreadSimpleSeq : public ::testing::Test {
  protected:
   coverage_Graph g;
@@ -114,6 +187,41 @@ TEST(InduceGenotypes_ThreadAmbigSeq, FlexibleTreatmentOfAmbiguity) {
   EXPECT_NO_THROW(get_single_endpoint(endpoints, "", false));
 }
 
+TEST(InduceGenotypes_ThreadAmbigSeq, EndpointsThreadBackToRoot) {
+  auto ambiguous_prg = prg_string_to_ints("AA[A,AA]A[AA,A]");
+  coverage_Graph g = coverage_Graph{PRG_String{ambiguous_prg}};
+
+  auto endpoints = thread_sequence(g.root, "AAAAAA");
+  ASSERT_EQ(endpoints.size(), 3);
+  for (auto const& endpoint : endpoints) {
+    auto cur_Node = endpoint;
+    while (cur_Node->get_parent() != nullptr) {
+      auto const& parent = cur_Node->get_parent();
+      EXPECT_EQ(cur_Node->get_offset(),
+                parent->get_offset() +
+                    parent->get_prg_node()->get_sequence_size());
+      cur_Node = parent;
+    }
+    EXPECT_EQ(cur_Node->get_prg_node(), g.root);
+    EXPECT_EQ(cur_Node->get_offset(), 0);
+  }
+}
+
+TEST(InduceGenotypes_ThreadLongSeq, ManySites_SingleEndpoint) {
+  std::string prg_string, sequence;
+  for (int i = 0; i < 5000; ++i) {
+    prg_string += "CT[A,G]";
+    sequence += (i % 3 == 0) ? "CTG" : "CTA";
+  }
+  prg_string += "T";
+  sequence += "T";
+  auto g = coverage_Graph{PRG_String{prg_string_to_ints(prg_string)}};
+
+  auto endpoints = thread_sequence(g.root, sequence);
+  ASSERT_EQ(endpoints.size(), 1);
+  EXPECT_EQ(endpoints.back()->get_offset(), sequence.size());
+}
+
 TEST(InduceGenotypes_NonConsumingInputSequence, LongestPathReturned) {
   // The threading process allows input sequences that consume the full graph
   // but not the full input sequence.
@@ -210,3 +318,49 @@ TEST_F(TestInduceGenotypes_InduceOneSeq,
   EXPECT_EQ(expected_seqs, std::vector<std::string>({"C", "GGGGA", "GGG"}));
   EXPECT_EQ(expected_ids, AlleleIds({1, 2, 1}));
 }
+
+class TestInduceGenotypes_AllSeqs : public ::testing::Test {
+ protected:
+  void SetUp() {
+    PRG_String{prg_string_to_ints("AT[,C,GG]AA[TA,AA,G[GG,GGG]A,]CA")}.write(
+        params.encoded_prg_fpath);
+  }
+  void TearDown() {
+    for (auto const& fpath : {params.encoded_prg_fpath,
+                              params.input_sequences_fpath,
+                              params.json_out_fpath})
+      fs::remove(fpath);
+  }
+
+  void write_fasta(std::string const& content) {
+    std::ofstream fasta(params.input_sequences_fpath);
+    fasta << content;
+  }
+
+  fs::path const test_data_dir =
+      fs::path(__FILE__).parent_path() / "test_data";
+  SimulateParams params = [this]() {
+    SimulateParams result;
+    result.encoded_prg_fpath = test_data_dir / "tmp_induce_prg.bin";
+    result.input_sequences_fpath = test_data_dir / "tmp_induce_seqs.fasta";
+    result.json_out_fpath = test_data_dir / "tmp_induce.json";
+    return result;
+  }();
+};
+
+TEST_F(TestInduceGenotypes_AllSeqs, GivenDistinctIDs_OneSamplePerSequence) {
+  write_fasta(">seq1 first\nATAATACA\n>seq2\nATCAAGGGGACA\n");
+  gram::commands::simulate::run(params);
+
+  std::ifstream json_in(params.json_out_fpath);
+  auto const samples = JSON::parse(json_in).at("Samples");
+  ASSERT_EQ(samples.size(), 2);
+  EXPECT_EQ(samples.at(0).at("Name"), "seq1");
+  EXPECT_EQ(samples.at(1).at("Name"), "seq2");
+}
+
+TEST_F(TestInduceGenotypes_AllSeqs, GivenRepeatedID_Throws) {
+  write_fasta(">seq1 first\nATAATACA\n>seq1 second\nATCAAGGGGACA\n");
+  EXPECT_THROW(gram::commands::simulate::run(params),
+               gram::json::JSONConsistencyException);
+}